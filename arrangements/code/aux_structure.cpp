@@ -252,4 +252,29 @@ inline UIPair AuxiliaryStructure::uniquePair(const UIPair &uip) const
 {
     if(uip.first < uip.second) return  uip;
     return std::make_pair(uip.second, uip.first);
-}
\ No newline at end of file
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline size_t AuxiliaryStructure::memoryUsage() const
+{
+    size_t bytes = heap_bytes(intersection_list) + tri_has_intersections.capacity() / 8;
+
+    bytes += heap_bytes(coplanar_tris) + heap_bytes(tri2pts) + heap_bytes(edge2pts) + heap_bytes(tri2segs);
+    for(const auto &l : coplanar_tris) bytes += heap_bytes(l);
+    for(const auto &l : tri2pts)       bytes += heap_bytes(l);
+    for(const auto &l : edge2pts)      bytes += heap_bytes(l);
+    for(const auto &l : tri2segs)      bytes += heap_bytes(l);
+
+    bytes += hash_heap_bytes(seg2tris);
+    for(const auto &s : seg2tris) bytes += heap_bytes(s.second);
+
+    // btree nodes are not exposed: count the stored values only
+    bytes += v_map.map.size() * sizeof(std::pair<aux_point, uint>);
+
+    bytes += hash_heap_bytes(visited_pockets) + hash_heap_bytes(pockets_map);
+    for(const auto &p : visited_pockets) bytes += heap_bytes(p);
+    for(const auto &p : pockets_map)     bytes += heap_bytes(p.first);
+
+    return bytes;
+}
@@ -178,6 +178,8 @@ class AuxiliaryStructure
         inline const auto& get_vmap() const { return v_map; }
         inline auto& get_vmap() { return v_map; }
 
+        inline size_t memoryUsage() const; // approximate heap bytes
+
     private:
         uint    num_original_vtx;
         uint    num_original_tris;
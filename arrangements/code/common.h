@@ -38,7 +38,7 @@
 #ifndef COMMON_H
 #define COMMON_H
 
-#define NBIT 32
+#include "label_set.h"
 
 
 enum Plane {XY, YZ, ZX};
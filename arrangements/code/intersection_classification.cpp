@@ -50,12 +50,12 @@ inline void find_intersections(const std::vector<cinolib::vec3d> & verts, const
     cinolib::Octree o(8,1000); // max 1000 elements per leaf, depth permitting
     o.build_from_vectors(verts, tris);
 
-    intersections.reserve((int)sqrt(tris.size()));
-    tbb::spin_mutex mutex;
+    pair_buffers buffers; // one for each thread, no locks
     tbb::parallel_for((uint)0, (uint)o.leaves.size(), [&](uint i)
     {        
         auto & leaf = o.leaves.at(i);
         if(leaf->item_indices.empty()) return;
+        std::vector<uint64_t> &local = buffers.local();
         for(uint j=0;   j<leaf->item_indices.size()-1; ++j)
         for(uint k=j+1; k<leaf->item_indices.size();   ++k)
         {
@@ -68,15 +68,12 @@ inline void find_intersections(const std::vector<cinolib::vec3d> & verts, const
                 const cinolib::Triangle *t0 = dynamic_cast<cinolib::Triangle*>(T0);
                 const cinolib::Triangle *t1 = dynamic_cast<cinolib::Triangle*>(T1);
                 if(t0->intersects_triangle(t1->v,true)) // precise check (exact if CINOLIB_USES_SHEWCHUK_PREDICATES is defined)
-                {
-                    std::lock_guard<tbb::spin_mutex> guard(mutex);
-                    intersections.push_back(cinolib::unique_pair(tid0,tid1));
-                }
+                    local.push_back(pack_pair(std::min(tid0, tid1), std::max(tid0, tid1)));
             }
         }
     });
 
-    remove_duplicates(intersections);
+    merge_pair_buffers(buffers, intersections);
 }
 
 inline void detectIntersections(const TriangleSoup &ts, std::vector<std::pair<uint, uint> > &intersection_list)
@@ -211,10 +211,20 @@ inline void save(const std::string &filename, std::vector<double> &coords, std::
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline void writeIMPL(const string &filename, const std::vector<genericPoint *> &verts, const std::vector<uint> &tris, const std::vector<std::bitset<NBIT> > &labels)
+inline void writeIMPL(const string &filename, const std::vector<genericPoint *> &verts, const std::vector<uint> &tris, const std::vector<LabelSet > &labels)
 {
     setlocale(LC_NUMERIC, "en_US.UTF-8"); // makes sure "." is the decimal separator
 
+    // labels are written as unsigned long masks (see readIMPL)
+    for(const LabelSet &l : labels)
+    {
+        if(l.any() && l.last() >= 8 * sizeof(unsigned long))
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : writeIMPL() : label " << l.last() << " can't be stored in the file " << filename << std::endl;
+            exit(-1);
+        }
+    }
+
     FILE *fp = fopen(filename.c_str(), "w");
 
     if(!fp)
@@ -287,7 +297,7 @@ inline void writeIMPL(const string &filename, const std::vector<genericPoint *>
     fclose(fp);
 }
 
-inline void readIMPL(const std::string &filename, std::vector<genericPoint*> &verts, std::vector<uint> &tris, std::vector<std::bitset<NBIT>> &labels)
+inline void readIMPL(const std::string &filename, std::vector<genericPoint*> &verts, std::vector<uint> &tris, std::vector<LabelSet> &labels)
 {
     std::ifstream fp(filename);
     if(!fp.is_open())
@@ -335,7 +345,7 @@ inline void readIMPL(const std::string &filename, std::vector<genericPoint*> &ve
                 tris[3 * curr_t_id] = v0;
                 tris[3 * curr_t_id +1] = v1;
                 tris[3 * curr_t_id +2] = v2;
-                labels[curr_t_id] = static_cast<unsigned long>(l);
+                labels[curr_t_id] = LabelSet::fromUlong(static_cast<unsigned long>(l));
                 curr_t_id++;
             } break;
 
@@ -67,9 +67,9 @@ inline bool fixCoincidentVertices(cinolib::Trimesh<> &m);
 
 inline void save(const std::string &filename, std::vector<double> &coords, std::vector<uint> &tris);
 
-inline void writeIMPL(const std::string &filename, const std::vector<genericPoint*> &verts, const std::vector<uint> &tris, const std::vector<std::bitset<NBIT>> &labels);
+inline void writeIMPL(const std::string &filename, const std::vector<genericPoint*> &verts, const std::vector<uint> &tris, const std::vector<LabelSet> &labels);
 
-inline void readIMPL(const std::string &filename, std::vector<genericPoint*> &verts, std::vector<uint> &tris, std::vector<std::bitset<NBIT>> &labels);
+inline void readIMPL(const std::string &filename, std::vector<genericPoint*> &verts, std::vector<uint> &tris, std::vector<LabelSet> &labels);
 
 #include "io_functions.cpp"
 
@@ -0,0 +1,282 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2020 Gianmarco Cherchi, Marco Livesu, Riccardo Scateni e Marco Attene   *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://people.unica.it/gianmarcocherchi/                                        *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ *      Riccardo Scateni (riccardo@unica.it)                                             *
+ *      https://people.unica.it/riccardoscateni/                                         *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "label_set.h"
+
+#include <cassert>
+#include <stdexcept>
+
+inline LabelSet::LabelSet(uint label)
+{
+    ids.push_back(label);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool LabelSet::operator[](uint label) const
+{
+    return test(label);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool LabelSet::test(uint label) const
+{
+    if(ids.size() < 8) // linear search is faster on few labels
+    {
+        for(uint l : ids)
+        {
+            if(l == label) return true;
+            if(l > label)  return false;
+        }
+        return false;
+    }
+
+    return std::binary_search(ids.begin(), ids.end(), label);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void LabelSet::set(uint label, bool value)
+{
+    if(!value)
+    {
+        reset(label);
+        return;
+    }
+
+    auto it = std::lower_bound(ids.begin(), ids.end(), label);
+    if(it == ids.end() || *it != label) ids.insert(it, label);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void LabelSet::reset(uint label)
+{
+    auto it = std::lower_bound(ids.begin(), ids.end(), label);
+    if(it != ids.end() && *it == label) ids.erase(it);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void LabelSet::reset()
+{
+    ids.clear();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint LabelSet::count() const
+{
+    return static_cast<uint>(ids.size());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool LabelSet::any() const
+{
+    return !ids.empty();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool LabelSet::none() const
+{
+    return ids.empty();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint LabelSet::first() const
+{
+    assert(!ids.empty() && "empty label set");
+    return ids.front();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint LabelSet::last() const
+{
+    assert(!ids.empty() && "empty label set");
+    return ids.back();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline LabelSet::const_iterator LabelSet::begin() const
+{
+    return ids.begin();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline LabelSet::const_iterator LabelSet::end() const
+{
+    return ids.end();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline LabelSet &LabelSet::operator|=(const LabelSet &l)
+{
+    if(l.ids.empty()) return *this;
+
+    absl::InlinedVector<uint, 4> res;
+    res.reserve(ids.size() + l.ids.size());
+    std::set_union(ids.begin(), ids.end(), l.ids.begin(), l.ids.end(), std::back_inserter(res));
+    ids.swap(res);
+    return *this;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline LabelSet &LabelSet::operator&=(const LabelSet &l)
+{
+    absl::InlinedVector<uint, 4> res;
+    std::set_intersection(ids.begin(), ids.end(), l.ids.begin(), l.ids.end(), std::back_inserter(res));
+    ids.swap(res);
+    return *this;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline LabelSet &LabelSet::operator^=(const LabelSet &l)
+{
+    absl::InlinedVector<uint, 4> res;
+    res.reserve(ids.size() + l.ids.size());
+    std::set_symmetric_difference(ids.begin(), ids.end(), l.ids.begin(), l.ids.end(), std::back_inserter(res));
+    ids.swap(res);
+    return *this;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool LabelSet::operator==(const LabelSet &l) const
+{
+    return ids == l.ids;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool LabelSet::operator!=(const LabelSet &l) const
+{
+    return ids != l.ids;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool LabelSet::intersects(const LabelSet &l) const
+{
+    auto i = ids.begin(), j = l.ids.begin();
+    while(i != ids.end() && j != l.ids.end())
+    {
+        if(*i == *j) return true;
+        if(*i < *j) ++i;
+        else        ++j;
+    }
+    return false;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline unsigned long LabelSet::to_ulong() const
+{
+    // same as std::bitset::to_ulong, the shift would be undefined for the larger labels
+    if(!ids.empty() && ids.back() >= 8 * sizeof(unsigned long))
+        throw std::overflow_error("LabelSet::to_ulong: label " + std::to_string(ids.back()) + " does not fit in an unsigned long");
+
+    unsigned long mask = 0;
+    for(uint l : ids) mask |= (1ul << l);
+    return mask;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::string LabelSet::to_string(uint num_labels) const
+{
+    std::string s(num_labels, '0'); // same order of std::bitset::to_string, label 0 is the last char
+
+    for(uint l : ids)
+        if(l < num_labels) s[num_labels - 1 - l] = '1';
+
+    return s;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline size_t LabelSet::heapBytes() const
+{
+    return (ids.capacity() > 4) ? ids.capacity() * sizeof(uint) : 0;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline LabelSet LabelSet::fromUlong(unsigned long mask)
+{
+    LabelSet ls;
+    for(uint l = 0; mask != 0; l++, mask >>= 1)
+        if(mask & 1ul) ls.ids.push_back(l);
+
+    return ls;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline LabelSet operator|(const LabelSet &l0, const LabelSet &l1)
+{
+    LabelSet res = l0;
+    res |= l1;
+    return res;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline LabelSet operator&(const LabelSet &l0, const LabelSet &l1)
+{
+    LabelSet res = l0;
+    res &= l1;
+    return res;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline LabelSet operator^(const LabelSet &l0, const LabelSet &l1)
+{
+    LabelSet res = l0;
+    res ^= l1;
+    return res;
+}
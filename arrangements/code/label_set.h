@@ -0,0 +1,120 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2020 Gianmarco Cherchi, Marco Livesu, Riccardo Scateni e Marco Attene   *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://people.unica.it/gianmarcocherchi/                                        *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ *      Riccardo Scateni (riccardo@unica.it)                                             *
+ *      https://people.unica.it/riccardoscateni/                                         *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef LABEL_SET_H
+#define LABEL_SET_H
+
+#include <string>
+#include <algorithm>
+#include <iterator>
+#include <absl/container/inlined_vector.h>
+
+typedef unsigned int uint;
+
+/* The set of input meshes (labels) a triangle belongs to. The labels are stored as a sorted list of ids,
+ * so that the memory used by each triangle depends on the number of labels it actually has and not on
+ * the total number of input meshes. The interface mimics std::bitset, which was used before.
+*/
+
+class LabelSet
+{
+    public:
+
+        using const_iterator = absl::InlinedVector<uint, 4>::const_iterator;
+
+        inline LabelSet() {}
+
+        inline explicit LabelSet(uint label);
+
+        inline bool operator[](uint label) const;
+
+        inline bool test(uint label) const;
+
+        inline void set(uint label, bool value = true);
+
+        inline void reset(uint label);
+
+        inline void reset();
+
+        inline uint count() const;
+
+        inline bool any() const;
+
+        inline bool none() const;
+
+        inline uint first() const;
+
+        inline uint last() const;
+
+        inline const_iterator begin() const;
+
+        inline const_iterator end() const;
+
+        inline LabelSet &operator|=(const LabelSet &l);
+
+        inline LabelSet &operator&=(const LabelSet &l);
+
+        inline LabelSet &operator^=(const LabelSet &l);
+
+        inline bool operator==(const LabelSet &l) const;
+
+        inline bool operator!=(const LabelSet &l) const;
+
+        inline bool intersects(const LabelSet &l) const; // same as (*this & l).any(), without building the intersection
+
+        inline unsigned long to_ulong() const; // throws std::overflow_error (as std::bitset) if a label does not fit in an unsigned long
+
+        inline std::string to_string(uint num_labels) const;
+
+        inline size_t heapBytes() const; // 0 as long as the labels are stored inline
+
+        static inline LabelSet fromUlong(unsigned long mask);
+
+    private:
+
+        absl::InlinedVector<uint, 4> ids; // sorted, without repetitions
+};
+
+inline LabelSet operator|(const LabelSet &l0, const LabelSet &l1);
+
+inline LabelSet operator&(const LabelSet &l0, const LabelSet &l1);
+
+inline LabelSet operator^(const LabelSet &l0, const LabelSet &l1);
+
+#include "label_set.cpp"
+
+#endif // LABEL_SET_H
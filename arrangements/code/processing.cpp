@@ -119,8 +119,8 @@ inline void mergeDuplicatedVertices(const std::vector<double> &in_coords, const
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline void removeDegenerateAndDuplicatedTriangles(const std::vector<genericPoint*> &verts, const std::vector<std::bitset<NBIT> > &in_labels,
-                                                   std::vector<uint> &tris, std::vector< std::bitset<NBIT> > &labels)
+inline void removeDegenerateAndDuplicatedTriangles(const std::vector<genericPoint*> &verts, const std::vector<LabelSet > &in_labels,
+                                                   std::vector<uint> &tris, std::vector< LabelSet > &labels)
 {
     labels = in_labels;
 
@@ -136,7 +136,7 @@ inline void removeDegenerateAndDuplicatedTriangles(const std::vector<genericPoin
         uint v0_id = tris[(3 * t_id)];
         uint v1_id = tris[(3 * t_id) +1];
         uint v2_id = tris[(3 * t_id) +2];
-        std::bitset<NBIT> l = labels[t_id];
+        LabelSet l = labels[t_id];
 
         if(!cinolib::points_are_colinear_3d(verts[v0_id]->toExplicit3D().ptr(),
                                             verts[v1_id]->toExplicit3D().ptr(),
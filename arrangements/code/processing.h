@@ -53,8 +53,8 @@ inline void mergeDuplicatedVertices(const std::vector<double> &in_coords, const
                                     point_arena& arena, std::vector<genericPoint*> &verts, std::vector<uint> &tris,
                                     bool parallel);
 
-inline void removeDegenerateAndDuplicatedTriangles(const std::vector<genericPoint *> &verts, const std::vector<std::bitset<NBIT> > &in_labels,
-                                                   std::vector<uint> &tris, std::vector<std::bitset<NBIT> > &labels);
+inline void removeDegenerateAndDuplicatedTriangles(const std::vector<genericPoint *> &verts, const std::vector<LabelSet > &in_labels,
+                                                   std::vector<uint> &tris, std::vector<LabelSet > &labels);
 
 inline void freePointsMemory(std::vector<genericPoint*> &points);
 
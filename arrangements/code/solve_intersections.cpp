@@ -37,8 +37,8 @@
 
 #include "solve_intersections.h"
 
-inline void meshArrangementPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector< std::bitset<NBIT> > &in_labels, point_arena &arena,
-                                    std::vector<genericPoint*> &vertices, std::vector<uint> &out_tris, std::vector< std::bitset<NBIT> > &out_labels)
+inline void meshArrangementPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector< LabelSet > &in_labels, point_arena &arena,
+                                    std::vector<genericPoint*> &vertices, std::vector<uint> &out_tris, std::vector< LabelSet > &out_labels)
 {
     initFPU();
 
@@ -47,7 +47,7 @@ inline void meshArrangementPipeline(const std::vector<double> &in_coords, const
     double multiplier = computeMultiplier(in_coords);
 
     std::vector<uint> tmp_tris;
-    std::vector< std::bitset<NBIT> > tmp_labels;
+    std::vector< LabelSet > tmp_labels;
 
     mergeDuplicatedVertices(in_coords, in_tris, arena, vertices, tmp_tris, true);
 
@@ -72,7 +72,7 @@ inline void solveIntersections(const std::vector<double> &in_coords, const std::
                                std::vector<double> &out_coords, std::vector<uint> &out_tris)
 {
     std::vector<genericPoint*> vertices;
-    std::vector< std::bitset<NBIT>> tmp_in_labels(in_tris.size() / 3), out_labels;
+    std::vector< LabelSet> tmp_in_labels(in_tris.size() / 3), out_labels;
 
     meshArrangementPipeline(in_coords, in_tris, tmp_in_labels, arena, vertices, out_tris, out_labels);
 
@@ -85,7 +85,7 @@ inline void solveIntersections(const std::vector<double> &in_coords, const std::
 inline void solveIntersections(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, point_arena &arena,
                                std::vector<genericPoint *> &out_vertices, std::vector<uint> &out_tris)
 {
-    std::vector< std::bitset<NBIT>> tmp_in_labels(in_tris.size() / 3), out_labels;
+    std::vector< LabelSet> tmp_in_labels(in_tris.size() / 3), out_labels;
 
     meshArrangementPipeline(in_coords, in_tris, tmp_in_labels, arena, out_vertices, out_tris, out_labels);
 }
@@ -93,13 +93,13 @@ inline void solveIntersections(const std::vector<double> &in_coords, const std::
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 inline void solveIntersections(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels, point_arena &arena,
-                                  std::vector<double> &out_coords, std::vector<uint> &out_tris, std::vector< std::bitset<NBIT> > &out_labels)
+                                  std::vector<double> &out_coords, std::vector<uint> &out_tris, std::vector< LabelSet > &out_labels)
 {
     std::vector<genericPoint*> vertices;
-    std::vector< std::bitset<NBIT>> tmp_in_labels(in_labels.size());
+    std::vector< LabelSet> tmp_in_labels(in_labels.size());
 
     for(uint i = 0; i < in_labels.size(); i++)
-        tmp_in_labels[i][in_labels[i]] = 1;
+        tmp_in_labels[i].set(in_labels[i]);
 
     meshArrangementPipeline(in_coords, in_tris, tmp_in_labels, arena, vertices, out_tris, out_labels);
 
@@ -110,12 +110,12 @@ inline void solveIntersections(const std::vector<double> &in_coords, const std::
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 inline void solveIntersections(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels, point_arena &arena,
-                               std::vector<genericPoint *> &vertices, std::vector<uint> &out_tris, std::vector<std::bitset<NBIT> > &out_labels)
+                               std::vector<genericPoint *> &vertices, std::vector<uint> &out_tris, std::vector<LabelSet > &out_labels)
 {
-    std::vector< std::bitset<NBIT>> tmp_in_labels(in_labels.size());
+    std::vector< LabelSet> tmp_in_labels(in_labels.size());
 
     for(uint i = 0; i < in_labels.size(); i++)
-        tmp_in_labels[i][in_labels[i]] = 1;
+        tmp_in_labels[i].set(in_labels[i]);
 
     meshArrangementPipeline(in_coords, in_tris, tmp_in_labels, arena, vertices, out_tris, out_labels);
 }
@@ -44,14 +44,13 @@
 #include "intersection_classification.h"
 #include "triangulation.h"
 
-#include <bitset>
 
 /**
 * This function performs the mesh arrangement of an input triangle set.
 * Use one of the solveInterctions functions to interface whit it.
 */
-inline void meshArrangementPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector< std::bitset<NBIT> > &in_labels, point_arena &arena,
-                                    std::vector<genericPoint*> &out_vertices, std::vector<uint> &out_tris, std::vector< std::bitset<NBIT> > &out_labels);
+inline void meshArrangementPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector< LabelSet > &in_labels, point_arena &arena,
+                                    std::vector<genericPoint*> &out_vertices, std::vector<uint> &out_tris, std::vector< LabelSet > &out_labels);
 
 
 /**
@@ -97,10 +96,10 @@ inline void solveIntersections(const std::vector<double> &in_coords, const std::
  * @param arena: a temporary structure of type "point_arena" to efficiently manage the memory
  * @param out_coords: the coordinates of the points after the arrangement (the coordinates of the intersection points are approximate)
  * @param out_tris: the indices of the vertices of the output triangles
- * @param out_labels: a vector of bitset containing, for each output triangle, the set of labels of the generating input triangles
+ * @param out_labels: a vector of label sets containing, for each output triangle, the set of labels of the generating input triangles
  */
 inline void solveIntersections(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels, point_arena &arena,
-                               std::vector<double> &out_coords, std::vector<uint> &out_tris, std::vector< std::bitset<NBIT> > &out_labels);
+                               std::vector<double> &out_coords, std::vector<uint> &out_tris, std::vector< LabelSet > &out_labels);
 
 
 /**
@@ -113,14 +112,14 @@ inline void solveIntersections(const std::vector<double> &in_coords, const std::
  * @param arena: a temporary structure of type "point_arena" to efficiently manage the memory
  * @param out_vertices: the set of vertices after the arrangement in implicit form (type: genericPoint*)
  * @param out_tris: the indices of the vertices of the output triangles
- * @param out_labels: a vector of bitset containing, for each output triangle, the set of labels of the generating input triangles
+ * @param out_labels: a vector of label sets containing, for each output triangle, the set of labels of the generating input triangles
  *
  * IMPORTANT: if you use this function
  * - if, at some point, you need an approximation of your vertices you need to call the computeApproximateCoordinates(...) function contained in processing.h
  * - remember to free the dynamic allocated memory of the implicit points by calling the freePointsMemory(...) function contained in processing.h
  */
 inline void solveIntersections(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels, point_arena &arena,
-                               std::vector<genericPoint*> &vertices, std::vector<uint> &out_tris, std::vector< std::bitset<NBIT> > &out_labels);
+                               std::vector<genericPoint*> &vertices, std::vector<uint> &out_tris, std::vector< LabelSet > &out_labels);
 
 
 #include "solve_intersections.cpp"
@@ -347,7 +347,7 @@ inline bool TriangleSoup::triContainsEdge(const uint t_id, uint ev0_id, uint ev1
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline std::bitset<NBIT> TriangleSoup::triLabel(uint t_id) const
+inline const LabelSet &TriangleSoup::triLabel(uint t_id) const
 {
     assert(t_id < numTris() && "t_id out of range");
     return tri_labels[t_id];
@@ -49,7 +49,6 @@
 
 #include <vector>
 #include <map>
-#include <bitset>
 
 typedef std::pair<uint, uint> Edge;
 
@@ -60,7 +59,7 @@ class TriangleSoup
 {
     public:
 
-        inline TriangleSoup(point_arena& arena, std::vector<genericPoint*> &in_vertices, std::vector<uint> &in_tris, std::vector< std::bitset<NBIT> > &labels, double multiplier, bool parallel)
+        inline TriangleSoup(point_arena& arena, std::vector<genericPoint*> &in_vertices, std::vector<uint> &in_tris, std::vector< LabelSet > &labels, double multiplier, bool parallel)
             : vertices(in_vertices), triangles(in_tris), tri_labels(labels)
         {
             init(arena, multiplier, parallel);
@@ -120,7 +119,7 @@ class TriangleSoup
 
         inline bool triContainsEdge(const uint t_id, uint ev0_id, uint ev1_id) const;
 
-        inline std::bitset<NBIT> triLabel(uint t_id) const;
+        inline const LabelSet &triLabel(uint t_id) const;
 
         // JOLLY POINTS
         inline const genericPoint* jollyPoint(uint off) const;
@@ -134,7 +133,7 @@ class TriangleSoup
         std::vector<Edge>               edges;
 
         std::vector<uint>               &triangles;
-        std::vector<std::bitset<NBIT>>  &tri_labels;
+        std::vector<LabelSet>           &tri_labels;
         std::vector<Plane>              tri_planes;
 
         std::vector<genericPoint*>      jolly_points;
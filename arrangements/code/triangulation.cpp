@@ -48,7 +48,7 @@
 
 #include <tbb/tbb.h>
 
-inline void triangulateSingleTriangle(TriangleSoup &ts, point_arena& arena, FastTrimesh &subm, uint t_id, AuxiliaryStructure &g, std::vector<uint> &new_tris, std::vector< std::bitset<NBIT> > &new_labels, tbb::spin_mutex& mutex)
+inline void triangulateSingleTriangle(TriangleSoup &ts, point_arena& arena, FastTrimesh &subm, uint t_id, AuxiliaryStructure &g, std::vector<uint> &new_tris, std::vector< LabelSet > &new_labels, tbb::spin_mutex& mutex)
 {
     /*:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
      *                                  POINTS AND SEGMENTS RECOVERY
@@ -125,7 +125,8 @@ inline void triangulateSingleTriangle(TriangleSoup &ts, point_arena& arena, Fast
     }
 }
 
-inline void triangulation(TriangleSoup &ts, point_arena& arena, AuxiliaryStructure &g, std::vector<uint> &new_tris, std::vector< std::bitset<NBIT> > &new_labels)
+inline void triangulation(TriangleSoup &ts, point_arena& arena, AuxiliaryStructure &g, std::vector<uint> &new_tris, std::vector< LabelSet > &new_labels,
+                          const std::atomic<bool> *cancel)
 {
     new_labels.clear();
     new_tris.clear();
@@ -152,6 +153,8 @@ inline void triangulation(TriangleSoup &ts, point_arena& arena, AuxiliaryStructu
     // processing the triangles to split
     tbb::spin_mutex mutex;
     tbb::parallel_for((uint)0, (uint)tris_to_split.size(), [&](uint t) {
+        if(cancel && cancel->load(std::memory_order_relaxed)) return;
+
         uint t_id = tris_to_split[t];
         FastTrimesh subm(ts.triVert(t_id, 0),
                          ts.triVert(t_id, 1),
@@ -1016,7 +1019,7 @@ inline const auxvector<uint> &segmentTrianglesList(const UIPair &seg, const phma
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 inline void solvePocketsInCoplanarTriangle(const FastTrimesh &subm, AuxiliaryStructure &g, std::vector<uint> &new_tris,
-                                           std::vector< std::bitset<NBIT> > &new_labels, const std::bitset<NBIT> &label)
+                                           std::vector< LabelSet > &new_labels, const LabelSet &label)
 {
     std::vector< std::vector<uint> > tri_pockets;
     std::vector< std::set<uint> > polygons;
@@ -46,6 +46,8 @@
 #include "fast_trimesh.h"
 #include "tree.h"
 
+#include <atomic>
+
 #pragma GCC diagnostic ignored "-Wfloat-equal"
 
 typedef unsigned int uint;
@@ -60,9 +62,11 @@ inline bool lessThanP(std::pair<const genericPoint*, uint> &a, std::pair<const g
 }
 
 
-inline void triangulation(TriangleSoup &ts, point_arena& arena, AuxiliaryStructure &g, std::vector<uint> &new_tris, std::vector<std::bitset<NBIT> > &new_labels);
+// if cancel is set while running, the remaining triangles are skipped and the output is incomplete
+inline void triangulation(TriangleSoup &ts, point_arena& arena, AuxiliaryStructure &g, std::vector<uint> &new_tris, std::vector<LabelSet > &new_labels,
+                          const std::atomic<bool> *cancel = nullptr);
 
-inline void triangulateSingleTriangle(TriangleSoup &ts, FastTrimesh &subm, uint t_id, AuxiliaryStructure &g, std::vector<uint> &new_tris, std::vector<std::bitset<NBIT> > &new_labels);
+inline void triangulateSingleTriangle(TriangleSoup &ts, FastTrimesh &subm, uint t_id, AuxiliaryStructure &g, std::vector<uint> &new_tris, std::vector<LabelSet > &new_labels);
 
 inline void splitSingleTriangle(const TriangleSoup &ts, FastTrimesh &subm, const std::vector<uint> &points);
 inline void splitSingleTriangle(const TriangleSoup &ts, FastTrimesh &subm, const auxvector<uint> &points);
@@ -112,7 +116,7 @@ inline void splitSegmentInSubSegments(uint v_start, uint v_stop, uint mid_point,
 inline const auxvector<uint> &segmentTrianglesList(const UIPair &seg, const phmap::flat_hash_map< UIPair, UIPair > &sub_segments_map, const AuxiliaryStructure &g);
 
 inline void solvePocketsInCoplanarTriangle(const FastTrimesh &subm, AuxiliaryStructure &g, std::vector<uint> &new_tris,
-                                           std::vector<std::bitset<NBIT> > &new_labels, const std::bitset<NBIT> &label);
+                                           std::vector<LabelSet > &new_labels, const LabelSet &label);
 
 inline void findPocketsInTriangle(const FastTrimesh &subm, std::vector<std::vector<uint> > &tri_pockets, std::vector<std::set<uint> > &polygons);
 
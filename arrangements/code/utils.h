@@ -44,9 +44,14 @@
 #include <vector>
 #include <deque>
 #include <algorithm>
+#include <cstdint>
 
 #include <absl/container/flat_hash_map.h>
 
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/enumerable_thread_specific.h>
+
 template<typename T>
 inline void remove_duplicates(std::vector<T>& values) {
   std::sort(values.begin(), values.end());
@@ -88,6 +93,39 @@ inline void fast_remove_duplicates(std::vector<T>& values) {
   values.erase(my_unique(values), values.end());
 }
 
+// pairs of 32 bit ids packed in a 64 bit key: sorting the keys sorts the pairs lexicographically
+inline uint64_t pack_pair(uint32_t first, uint32_t second) {
+  return (static_cast<uint64_t>(first) << 32) | second;
+}
+
+// one buffer of packed pairs for each thread, filled without locks inside parallel loops
+typedef tbb::enumerable_thread_specific<std::vector<uint64_t>> pair_buffers;
+
+// appends the pairs collected in buffers to pairs, then sorts (and removes the duplicates) in parallel
+template<typename T>
+inline void merge_pair_buffers(pair_buffers& buffers, std::vector<std::pair<T, T>>& pairs, bool unique = true) {
+  std::vector<std::vector<uint64_t>*> locals;
+  std::vector<size_t> offsets = {pairs.size()};
+  for(auto& b : buffers) {
+    locals.push_back(&b);
+    offsets.push_back(offsets.back() + b.size());
+  }
+
+  std::vector<uint64_t> keys(offsets.back());
+  for(size_t i = 0; i < pairs.size(); i++) keys[i] = pack_pair(pairs[i].first, pairs[i].second);
+  tbb::parallel_for((size_t)0, locals.size(), [&](size_t i) {
+    std::copy(locals[i]->begin(), locals[i]->end(), keys.begin() + offsets[i]);
+  });
+
+  tbb::parallel_sort(keys.begin(), keys.end());
+  if(unique) keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+  pairs.resize(keys.size());
+  tbb::parallel_for((size_t)0, keys.size(), [&](size_t i) {
+    pairs[i] = std::make_pair(static_cast<T>(keys[i] >> 32), static_cast<T>(keys[i] & 0xFFFFFFFF));
+  });
+}
+
 template<typename T>
 inline bool contains(const std::vector<T>& values, T value) {
   for(auto& value_ : values) if(value == value_) return true; 
@@ -150,6 +188,22 @@ inline bool contains(const absl::InlinedVector<T, N>& values, T value) {
   return false;
 }
 
+// approximate heap memory held by containers (allocator overheads excluded)
+template<typename T>
+inline size_t heap_bytes(const std::vector<T>& values) {
+  return values.capacity() * sizeof(T);
+}
+
+template<typename T, size_t N>
+inline size_t heap_bytes(const absl::InlinedVector<T, N>& values) {
+  return (values.capacity() > N) ? values.capacity() * sizeof(T) : 0;
+}
+
+template<typename H>
+inline size_t hash_heap_bytes(const H& table) { // phmap/absl flat tables: one slot + one control byte per bucket
+  return table.capacity() * (sizeof(typename H::value_type) + 1);
+}
+
 #if 1
 
 template<typename T, size_t N>
@@ -176,6 +230,12 @@ struct bucket_arena {
     buckets.back().pop_back();
     if(buckets.back().empty()) buckets.pop_back();
   }
+
+  size_t heap_bytes() const {
+    size_t bytes = buckets.capacity() * sizeof(std::vector<T>);
+    for(auto& bucket : buckets) bytes += bucket.capacity() * sizeof(T);
+    return bytes;
+  }
 };
 
 struct point_arena {
@@ -183,6 +243,14 @@ struct point_arena {
   bucket_arena<implicitPoint3D_LPI, 1024 * 1024> edges;
   bucket_arena<explicitPoint3D, 1024> jolly;
   bucket_arena<implicitPoint3D_TPI, 1024 * 1024> tpi;
+
+  size_t num_buckets() const {
+    return edges.buckets.size() + jolly.buckets.size() + tpi.buckets.size();
+  }
+
+  size_t heap_bytes() const {
+    return init.capacity() * sizeof(explicitPoint3D) + edges.heap_bytes() + jolly.heap_bytes() + tpi.heap_bytes();
+  }
 };
 
 #else
@@ -0,0 +1,119 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "aabb_array.h"
+
+inline void AABBArray::resize(uint n)
+{
+    min_x.resize(n); min_y.resize(n); min_z.resize(n);
+    max_x.resize(n); max_y.resize(n); max_z.resize(n);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void AABBArray::set(uint i, const cinolib::AABB &b)
+{
+    min_x[i] = b.min.x(); min_y[i] = b.min.y(); min_z[i] = b.min.z();
+    max_x[i] = b.max.x(); max_y[i] = b.max.y(); max_z[i] = b.max.z();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint AABBArray::size() const
+{
+    return static_cast<uint>(min_x.size());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline const std::vector<double> &AABBArray::min(uint axis) const
+{
+    return axis == 0 ? min_x : (axis == 1 ? min_y : min_z);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool AABBArray::overlaps(uint i, const cinolib::AABB &b) const
+{
+    return !(max_x[i] < b.min.x() || min_x[i] > b.max.x() ||
+             max_y[i] < b.min.y() || min_y[i] > b.max.y() ||
+             max_z[i] < b.min.z() || min_z[i] > b.max.z());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+#ifdef __AVX2__
+
+// bit k set if the k-th of the 4 boxes loaded from the arrays does not overlap b
+#define AABB_ARRAY_REJECT_MASK(LOAD) \
+    _mm256_movemask_pd(_mm256_or_pd(_mm256_or_pd( \
+        _mm256_or_pd(_mm256_cmp_pd(LOAD(max_x), bmin_x, _CMP_LT_OQ), _mm256_cmp_pd(LOAD(min_x), bmax_x, _CMP_GT_OQ)), \
+        _mm256_or_pd(_mm256_cmp_pd(LOAD(max_y), bmin_y, _CMP_LT_OQ), _mm256_cmp_pd(LOAD(min_y), bmax_y, _CMP_GT_OQ))), \
+        _mm256_or_pd(_mm256_cmp_pd(LOAD(max_z), bmin_z, _CMP_LT_OQ), _mm256_cmp_pd(LOAD(min_z), bmax_z, _CMP_GT_OQ))))
+
+#endif
+
+template<typename F>
+inline void AABBArray::forEachOverlap(const cinolib::AABB &b, uint begin, uint end, F f) const
+{
+    uint i = begin;
+
+#ifdef __AVX2__
+    const __m256d bmin_x = _mm256_set1_pd(b.min.x()), bmax_x = _mm256_set1_pd(b.max.x());
+    const __m256d bmin_y = _mm256_set1_pd(b.min.y()), bmax_y = _mm256_set1_pd(b.max.y());
+    const __m256d bmin_z = _mm256_set1_pd(b.min.z()), bmax_z = _mm256_set1_pd(b.max.z());
+#define AABB_ARRAY_LOAD(v) _mm256_loadu_pd(v.data() + i)
+    for(; i + 4 <= end; i += 4)
+    {
+        int rejected = AABB_ARRAY_REJECT_MASK(AABB_ARRAY_LOAD);
+        if(rejected == 0xF) continue;
+        for(uint k = 0; k < 4; k++)
+            if(!(rejected & (1 << k))) f(i + k);
+    }
+#undef AABB_ARRAY_LOAD
+#endif
+
+    for(; i < end; i++)
+        if(overlaps(i, b)) f(i);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline size_t AABBArray::memoryUsage() const
+{
+    return 6 * min_x.capacity() * sizeof(double);
+}
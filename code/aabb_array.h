@@ -0,0 +1,82 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_AABB_ARRAY_H
+#define EXACT_BOOLEANS_AABB_ARRAY_H
+
+#include <cinolib/geometry/aabb.h>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/* Bounds of the broadphase items as separate coordinate arrays (structure of arrays), so that a box
+ * can be tested against 4 consecutive candidates at a time. The backends copy the items of each leaf
+ * in consecutive slots, since gathering scattered items is slower than testing the Triangle AABBs.
+ * Tests are closed and use the same comparisons as AABB::intersects_box, so they give the same
+ * answers. With AVX2 enabled at compile time (e.g. -mavx2) the SIMD kernel is used, otherwise a
+ * scalar loop
+*/
+
+class AABBArray
+{
+    public:
+
+        inline void resize(uint n);
+
+        inline void set(uint i, const cinolib::AABB &b);
+
+        inline uint size() const;
+
+        inline bool overlaps(uint i, const cinolib::AABB &b) const;
+
+        inline const std::vector<double> &min(uint axis) const; // min_x, min_y or min_z
+
+        // calls f(i) for each box i in [begin, end) that overlaps b
+        template<typename F>
+        inline void forEachOverlap(const cinolib::AABB &b, uint begin, uint end, F f) const;
+
+        inline size_t memoryUsage() const;
+
+        std::vector<double> min_x, min_y, min_z;
+        std::vector<double> max_x, max_y, max_z;
+};
+
+#include "aabb_array.cpp"
+
+#endif // EXACT_BOOLEANS_AABB_ARRAY_H
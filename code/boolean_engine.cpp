@@ -0,0 +1,187 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "boolean_engine.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+inline BooleanEngine::BooleanEngine(uint max_concurrent_jobs, uint max_threads_per_job)
+{
+    uint num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    if(max_concurrent_jobs == 0) max_concurrent_jobs = num_threads;
+    if(max_threads_per_job == 0) max_threads_per_job = num_threads;
+    this->max_threads_per_job = max_threads_per_job;
+
+    dispatchers.reserve(max_concurrent_jobs);
+    for(uint i = 0; i < max_concurrent_jobs; i++)
+        dispatchers.emplace_back([this]{ dispatcherLoop(); });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline BooleanEngine::~BooleanEngine()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    job_available.notify_all();
+
+    for(std::thread &d : dispatchers) d.join();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::future<BooleanResult> BooleanEngine::submit(BooleanJob job)
+{
+    // the pipeline exits on unsupported operations, which would take down all the jobs in flight
+    if(job.op != UNION && job.op != INTERSECTION && job.op != SUBTRACTION && job.op != XOR)
+    {
+        std::promise<BooleanResult> rejected;
+        rejected.set_exception(std::make_exception_ptr(std::invalid_argument("unsupported boolean operation")));
+        return rejected.get_future();
+    }
+
+    // the priority indexes the queues
+    if(job.priority != JOB_LOW && job.priority != JOB_NORMAL && job.priority != JOB_HIGH)
+    {
+        std::promise<BooleanResult> rejected;
+        rejected.set_exception(std::make_exception_ptr(std::invalid_argument("unsupported job priority")));
+        return rejected.get_future();
+    }
+
+    QueuedJob qj;
+    qj.job = std::move(job);
+    std::future<BooleanResult> res = qj.result.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(!stop && "engine stopped");
+        queues[qj.job.priority].push_back(std::move(qj));
+    }
+    job_available.notify_one();
+
+    return res;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint BooleanEngine::numPendingJobs() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<uint>(queues[JOB_LOW].size() + queues[JOB_NORMAL].size() + queues[JOB_HIGH].size());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint BooleanEngine::maxConcurrentJobs() const
+{
+    return static_cast<uint>(dispatchers.size());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint BooleanEngine::maxThreadsPerJob() const
+{
+    return max_threads_per_job;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BooleanEngine::dispatcherLoop()
+{
+    // an arena captures the floating point settings of the thread that initializes it, and applies them
+    // to all of its tasks: the rounding mode required by the predicates must be set before that
+    initFPU();
+
+    while(true)
+    {
+        QueuedJob qj;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_available.wait(lock, [this]{ return stop || !queues[JOB_LOW].empty() || !queues[JOB_NORMAL].empty() || !queues[JOB_HIGH].empty(); });
+
+            int p = JOB_HIGH;
+            while(p >= JOB_LOW && queues[p].empty()) p--;
+            if(p < JOB_LOW) return; // stop requested and nothing left to do
+
+            qj = std::move(queues[p].front());
+            queues[p].pop_front();
+        }
+
+        try
+        {
+            // the dispatcher thread joins the arena, so it counts as one of the job threads
+            tbb::task_arena arena(static_cast<int>(jobConcurrency(qj.job)), 1, arenaPriority(qj.job.priority));
+            arena.initialize(); // here, with the FPU settings of this thread
+
+            BooleanResult res;
+            bool completed = false;
+            arena.execute([&]
+            {
+                completed = booleanPipeline(qj.job.in_coords, qj.job.in_tris, qj.job.in_labels, qj.job.op, res.coords, res.tris, res.labels);
+            });
+
+            if(!completed) throw std::runtime_error("boolean pipeline not completed");
+            qj.result.set_value(std::move(res));
+        }
+        catch(...)
+        {
+            qj.result.set_exception(std::current_exception());
+        }
+    }
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint BooleanEngine::jobConcurrency(const BooleanJob &job) const
+{
+    // a thread every 10K input triangles: below that the parallel stages cost more than they give
+    uint num_tris = static_cast<uint>(job.in_tris.size() / 3);
+    return std::max(1u, std::min(max_threads_per_job, num_tris / 10000 + 1));
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline tbb::task_arena::priority BooleanEngine::arenaPriority(JobPriority p)
+{
+    if(p == JOB_LOW)  return tbb::task_arena::priority::low;
+    if(p == JOB_HIGH) return tbb::task_arena::priority::high;
+    return tbb::task_arena::priority::normal;
+}
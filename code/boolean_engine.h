@@ -0,0 +1,128 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_BOOLEAN_ENGINE_H
+#define EXACT_BOOLEANS_BOOLEAN_ENGINE_H
+
+#include "booleans.h"
+
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include <tbb/task_arena.h>
+
+/* Runs independent boolean jobs concurrently, e.g. in a service process.
+ *
+ *  - each job runs in its own tbb::task_arena, so jobs do not compete for the threads of the global arena
+ *    and a single large job cannot take all the cores (at most max_threads_per_job threads each)
+ *  - at most max_concurrent_jobs jobs run at the same time, the other ones wait in the queue. Jobs with
+ *    higher priority are dequeued first, jobs with the same priority in order of submission
+ *  - small jobs get fewer threads, since they do not benefit from them
+ *
+ * submit can be called from any thread. The result (or the exception thrown by the job) is returned
+ * through the future: jobs with an unsupported operation or priority get std::invalid_argument without being run,
+ * and jobs that do not complete get std::runtime_error. Jobs already in the queue are completed before
+ * the engine is destroyed
+*/
+
+enum JobPriority {JOB_LOW = 0, JOB_NORMAL = 1, JOB_HIGH = 2};
+
+struct BooleanJob
+{
+    std::vector<double> in_coords;
+    std::vector<uint>   in_tris;
+    std::vector<uint>   in_labels;
+    BoolOp              op       = UNION;
+    JobPriority         priority = JOB_NORMAL;
+};
+
+struct BooleanResult
+{
+    std::vector<double>   coords;
+    std::vector<uint>     tris;
+    std::vector<LabelSet> labels;
+};
+
+class BooleanEngine
+{
+    public:
+
+        // 0 -> number of hardware threads
+        inline explicit BooleanEngine(uint max_concurrent_jobs = 0, uint max_threads_per_job = 0);
+
+        inline ~BooleanEngine();
+
+        BooleanEngine(const BooleanEngine &) = delete;
+        BooleanEngine &operator=(const BooleanEngine &) = delete;
+
+        inline std::future<BooleanResult> submit(BooleanJob job);
+
+        inline uint numPendingJobs() const;
+
+        inline uint maxConcurrentJobs() const;
+
+        inline uint maxThreadsPerJob() const;
+
+    private:
+
+        struct QueuedJob
+        {
+            BooleanJob                  job;
+            std::promise<BooleanResult> result;
+        };
+
+        std::deque<QueuedJob>   queues[3]; // one for each JobPriority
+        mutable std::mutex      mutex;
+        std::condition_variable job_available;
+        std::vector<std::thread> dispatchers;
+        uint                    max_threads_per_job;
+        bool                    stop = false;
+
+        // PRIVATE METHODS
+        inline void dispatcherLoop();
+
+        inline uint jobConcurrency(const BooleanJob &job) const;
+
+        inline static tbb::task_arena::priority arenaPriority(JobPriority p);
+};
+
+#include "boolean_engine.cpp"
+
+#endif // EXACT_BOOLEANS_BOOLEAN_ENGINE_H
@@ -0,0 +1,237 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "boolean_scheduler.h"
+
+inline BooleanScheduler::BooleanScheduler(bool skip_same_label_pairs)
+: skip_same_label_pairs(skip_same_label_pairs)
+{
+    worker = std::thread([this]{ workerLoop(); });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline BooleanScheduler::~BooleanScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+        control.cancel();
+    }
+    snapshot_available.notify_one();
+
+    worker.join();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline unsigned long long BooleanScheduler::submit(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                                                   const std::vector<uint> &in_labels, const BoolOp &op)
+{
+    unsigned long long id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.coords = in_coords; // reuses the capacity of the buffers swapped back by the worker
+        pending.tris   = in_tris;
+        pending.labels = in_labels;
+        pending.op     = op;
+        connectivity_pending = true;
+        id = post(true);
+    }
+    snapshot_available.notify_one();
+    return id;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline unsigned long long BooleanScheduler::submit(const std::vector<double> &in_coords, const BoolOp &op)
+{
+    unsigned long long id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(last_id > 0 && "no triangles and labels submitted yet");
+        pending.coords = in_coords;
+        pending.op     = op;
+        id = post(true);
+    }
+    snapshot_available.notify_one();
+    return id;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline unsigned long long BooleanScheduler::submit(const BoolOp &op)
+{
+    unsigned long long id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.op = op;
+        id = post(false);
+    }
+    snapshot_available.notify_one();
+    return id;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool BooleanScheduler::fetch(BooleanFrame &frame)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!front_ready) return false;
+
+    std::swap(front, frame); // the old buffers of frame are recycled by the worker
+    front_ready = false;
+    return true;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BooleanScheduler::setFrameReadyCallback(const std::function<void()> &callback)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    frame_ready_callback = callback;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint BooleanScheduler::numCompletedFrames() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_completed;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint BooleanScheduler::numCancelledRuns() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_cancelled;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint BooleanScheduler::numSkippedSnapshots() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_skipped;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// mutex must be locked by the caller
+inline unsigned long long BooleanScheduler::post(bool new_geometry)
+{
+    if(geometry_pending || op_pending) num_skipped++; // the previous snapshot is replaced before starting
+
+    if(new_geometry)
+    {
+        geometry_pending = true;
+        control.cancel(); // the geometry in flight is stale
+    }
+    op_pending = true;
+
+    pending.id = ++last_id;
+    pending.submit_time = std::chrono::steady_clock::now();
+    return pending.id;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BooleanScheduler::workerLoop()
+{
+    Snapshot current;
+
+    while(true)
+    {
+        bool new_geometry;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            snapshot_available.wait(lock, [this]{ return stop || geometry_pending || op_pending; });
+            if(stop) return;
+
+            new_geometry = geometry_pending;
+            if(geometry_pending) current.coords.swap(pending.coords);
+            if(connectivity_pending)
+            {
+                current.tris.swap(pending.tris);
+                current.labels.swap(pending.labels);
+            }
+            current.op          = pending.op;
+            current.id          = pending.id;
+            current.submit_time = pending.submit_time;
+
+            geometry_pending = connectivity_pending = op_pending = false;
+            control.reset(); // from now on, only a newer geometry cancels this run
+        }
+
+        std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+
+        back.arrangement_time = 0.0;
+        if(new_geometry)
+        {
+            if(!session.init(current.coords, current.tris, current.labels, nullptr, &control, skip_same_label_pairs))
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                num_cancelled++;
+                continue;
+            }
+            back.arrangement_time = lapTime(t);
+        }
+
+        if(!session.isInitialized()) continue; // no geometry yet
+
+        back.coords.clear();
+        back.tris.clear();
+        back.labels.clear();
+        session.evaluate(current.op, back.coords, back.tris, back.labels);
+        back.evaluation_time = lapTime(t);
+
+        back.op          = current.op;
+        back.snapshot_id = current.id;
+        back.latency     = std::chrono::duration<double>(std::chrono::steady_clock::now() - current.submit_time).count();
+
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(back, front);
+            front_ready = true;
+            num_completed++;
+            callback = frame_ready_callback;
+        }
+        if(callback) callback();
+    }
+}
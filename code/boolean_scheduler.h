@@ -0,0 +1,150 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_BOOLEAN_SCHEDULER_H
+#define EXACT_BOOLEANS_BOOLEAN_SCHEDULER_H
+
+#include "boolean_session.h"
+
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+/* Latest-wins boolean computation for interactive clients (viewers, editors).
+ *
+ *  - submit posts a snapshot of the input and returns immediately. Only the most recent snapshot is
+ *    computed: a geometry update cancels the computation in flight (see PipelineControl), and snapshots
+ *    posted while the worker is busy replace each other instead of queueing
+ *  - submitting only a new operation reuses the arrangement of the current geometry (see BooleanSession)
+ *  - results are double buffered: the worker fills the back frame, fetch swaps in the last completed one
+ *
+ * submit and fetch can be called from any thread, typically the UI one
+*/
+
+struct BooleanFrame
+{
+    std::vector<double>   coords;
+    std::vector<uint>     tris;
+    std::vector<LabelSet> labels;
+    BoolOp                op = NONE;
+
+    unsigned long long snapshot_id = 0; // as returned by submit
+
+    // seconds
+    double arrangement_time = 0.0; // 0 if only the operation changed
+    double evaluation_time  = 0.0;
+    double latency          = 0.0; // from submit to the result being ready
+};
+
+class BooleanScheduler
+{
+    public:
+
+        // skip_same_label_pairs is passed to BooleanSession::init: turn it off for self-intersecting inputs
+        inline explicit BooleanScheduler(bool skip_same_label_pairs = true);
+
+        inline ~BooleanScheduler();
+
+        BooleanScheduler(const BooleanScheduler &) = delete;
+        BooleanScheduler &operator=(const BooleanScheduler &) = delete;
+
+        // new input meshes
+        inline unsigned long long submit(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                                         const std::vector<uint> &in_labels, const BoolOp &op);
+
+        // new vertex coordinates, same triangles and labels of the previous submission
+        inline unsigned long long submit(const std::vector<double> &in_coords, const BoolOp &op);
+
+        // same input, different operation
+        inline unsigned long long submit(const BoolOp &op);
+
+        // swaps the most recent completed frame into frame. Returns false (and leaves frame untouched)
+        // if no frame has been completed since the last call
+        inline bool fetch(BooleanFrame &frame);
+
+        // called by the worker thread each time a frame is completed (e.g. to wake up the UI loop)
+        inline void setFrameReadyCallback(const std::function<void()> &callback);
+
+        inline uint numCompletedFrames() const;
+        inline uint numCancelledRuns() const;  // geometry updates superseded while computing
+        inline uint numSkippedSnapshots() const; // replaced before the worker could start them
+
+    private:
+
+        struct Snapshot
+        {
+            std::vector<double> coords;
+            std::vector<uint>   tris;
+            std::vector<uint>   labels;
+            BoolOp              op = NONE;
+            unsigned long long  id = 0;
+            std::chrono::steady_clock::time_point submit_time;
+        };
+
+        BooleanSession          session;   // only touched by the worker
+        const bool              skip_same_label_pairs;
+        PipelineControl         control;
+        Snapshot                pending;
+        bool                    geometry_pending     = false;
+        bool                    connectivity_pending = false;
+        bool                    op_pending           = false;
+        unsigned long long      last_id          = 0;
+
+        BooleanFrame            back;
+        BooleanFrame            front;
+        bool                    front_ready = false;
+        std::function<void()>   frame_ready_callback;
+
+        uint                    num_completed = 0;
+        uint                    num_cancelled = 0;
+        uint                    num_skipped   = 0;
+
+        mutable std::mutex      mutex;
+        std::condition_variable snapshot_available;
+        std::thread             worker;
+        bool                    stop = false;
+
+        // PRIVATE METHODS
+        inline unsigned long long post(bool new_geometry);
+
+        inline void workerLoop();
+};
+
+#include "boolean_scheduler.cpp"
+
+#endif // EXACT_BOOLEANS_BOOLEAN_SCHEDULER_H
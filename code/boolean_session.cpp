@@ -0,0 +1,139 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "boolean_session.h"
+
+inline bool BooleanSession::init(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels,
+                                 PipelineStats *stats, PipelineControl *control, bool skip_same_label_pairs)
+{
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    setStageRange(control, STAGE_MERGE, STAGE_INSIDE_OUT);
+
+    // the broadphase is kept across calls, so that its index can be refitted when only the vertices moved
+    std::unique_ptr<Broadphase> prev_broadphase = std::move(data.broadphase);
+    clear();
+    if(prev_broadphase && prev_broadphase->type() == defaultBroadphaseType()) data.broadphase = std::move(prev_broadphase);
+
+    if(!customLabelingPipeline(in_coords, in_tris, in_labels, data, stats, control, skip_same_label_pairs))
+    {
+        // a cancelled run still leaves a valid index, e.g. for the next geometry update of the same triangles
+        prev_broadphase = std::move(data.broadphase);
+        clear();
+        data.broadphase = std::move(prev_broadphase);
+        return false;
+    }
+
+    initialized = true;
+
+    if(stats) stats->total_time = lapTime(t0);
+    return true;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BooleanSession::evaluate(const BoolOp &op, std::vector<double> &bool_coords, std::vector<uint> &bool_tris,
+                                     std::vector< LabelSet > &bool_labels)
+{
+    std::vector<std::vector<double>> coords;
+    std::vector<std::vector<uint>> tris;
+    std::vector<std::vector<LabelSet>> tri_labels;
+
+    evaluate(std::vector<BoolOp>{op}, coords, tris, tri_labels);
+
+    bool_coords.swap(coords[0]);
+    bool_tris.swap(tris[0]);
+    bool_labels.swap(tri_labels[0]);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BooleanSession::evaluate(const std::vector<BoolOp> &ops, std::vector<std::vector<double>> &bool_coords,
+                                     std::vector<std::vector<uint>> &bool_tris, std::vector<std::vector<LabelSet>> &bool_labels,
+                                     PipelineStats *stats)
+{
+    assert(initialized && "session not initialized");
+
+    if(stats) stats->rss = currentRSS();
+
+    customSelectionPipeline(data, static_cast<uint>(ops.size()),
+                            [&](uint i, std::vector<uint8_t> &tri_mask){ return selectTriangles(data.labels, ops[i], tri_mask); },
+                            bool_coords, bool_tris, bool_labels, stats);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BooleanSession::evaluate(const CSGExpression &expr, std::vector<double> &bool_coords, std::vector<uint> &bool_tris,
+                                     std::vector< LabelSet > &bool_labels)
+{
+    assert(initialized && "session not initialized");
+
+    std::vector<std::vector<double>> coords;
+    std::vector<std::vector<uint>> tris;
+    std::vector<std::vector<LabelSet>> tri_labels;
+    customSelectionPipeline(data, 1,
+                            [&](uint, std::vector<uint8_t> &tri_mask){ return selectTriangles(data.labels, expr, tri_mask); },
+                            coords, tris, tri_labels);
+
+    bool_coords.swap(coords[0]);
+    bool_tris.swap(tris[0]);
+    bool_labels.swap(tri_labels[0]);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool BooleanSession::isInitialized() const
+{
+    return initialized;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint BooleanSession::numLabels() const
+{
+    return data.labels.num;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BooleanSession::clear()
+{
+    // the vertices point into the arena, so they are released together
+    data = BooleanData();
+
+    initialized = false;
+}
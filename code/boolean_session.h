@@ -0,0 +1,97 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_BOOLEAN_SESSION_H
+#define EXACT_BOOLEANS_BOOLEAN_SESSION_H
+
+#include "booleans.h"
+
+/* Usage:
+ *
+ *  i)   Call init with the input meshes: it computes the arrangement and classifies
+ *       all the patches as inside/outside the input meshes (the expensive part)
+ *  ii)  Call evaluate as many times as needed to extract the result of one or more
+ *       boolean operations. Only the triangle selection and the output compaction run here
+ *  iii) Call init again when the geometry changes
+ *
+ * The broadphase backend is the one returned by defaultBroadphaseType when init is called. It is
+ * kept by the session, and refitted (see Broadphase::refit) when init gets the same triangles with
+ * moved vertices, as in animations
+*/
+
+class BooleanSession
+{
+    public:
+
+        inline BooleanSession() {}
+
+        BooleanSession(const BooleanSession &) = delete;            // vertices point into the session arena
+        BooleanSession &operator=(const BooleanSession &) = delete;
+
+        // returns false if cancelled through control, leaving the session uninitialized (but keeping the broadphase).
+        // skip_same_label_pairs is the same of booleanPipeline
+        inline bool init(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels,
+                         PipelineStats *stats = nullptr, PipelineControl *control = nullptr, bool skip_same_label_pairs = true);
+
+        inline void evaluate(const BoolOp &op, std::vector<double> &bool_coords, std::vector<uint> &bool_tris,
+                             std::vector< LabelSet > &bool_labels);
+
+        // one result for each operation in ops, sharing the extraction of the vertex coordinates
+        inline void evaluate(const std::vector<BoolOp> &ops, std::vector<std::vector<double>> &bool_coords,
+                             std::vector<std::vector<uint>> &bool_tris, std::vector<std::vector<LabelSet>> &bool_labels,
+                             PipelineStats *stats = nullptr);
+
+        inline void evaluate(const CSGExpression &expr, std::vector<double> &bool_coords, std::vector<uint> &bool_tris,
+                             std::vector< LabelSet > &bool_labels);
+
+        inline bool isInitialized() const;
+
+        inline uint numLabels() const;
+
+    private:
+
+        BooleanData data;
+
+        bool initialized = false;
+
+        // PRIVATE METHODS
+        inline void clear();
+};
+
+#include "boolean_session.cpp"
+
+#endif // EXACT_BOOLEANS_BOOLEAN_SESSION_H
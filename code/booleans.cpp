@@ -39,110 +39,418 @@
 #include "io_functions.h"
 #include <tbb/tbb.h>
 
-inline void customBooleanPipeline(std::vector<genericPoint*>& arr_verts, std::vector<uint>& arr_in_tris,
-                                  std::vector<uint>& arr_out_tris, std::vector<std::bitset<NBIT>>& arr_in_labels,
+inline std::atomic<BroadphaseType> default_broadphase_type(BROADPHASE_OCTREE);
+
+inline void setDefaultBroadphaseType(BroadphaseType type)
+{
+    default_broadphase_type = type;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline BroadphaseType defaultBroadphaseType()
+{
+    return default_broadphase_type;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::atomic<bool> tri_tri_filter(true);
+
+inline void setTriTriFilter(bool enabled)
+{
+    tri_tri_filter = enabled;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool triTriFilter()
+{
+    return tri_tri_filter;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::unique_ptr<Broadphase> makeBroadphase(BroadphaseType type)
+{
+    if(type == BROADPHASE_BVH)    return std::make_unique<BVHBroadphase>();
+    if(type == BROADPHASE_MORTON) return std::make_unique<OctreeBroadphase>(0, 0, true);
+    if(type == BROADPHASE_DUAL)   return std::make_unique<DualTreeBroadphase>();
+    return std::make_unique<OctreeBroadphase>(); // parameters tuned on the input
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool customBooleanPipeline(std::vector<genericPoint*>& arr_verts, std::vector<uint>& arr_in_tris,
+                                  std::vector<uint>& arr_out_tris, std::vector<LabelSet>& arr_in_labels,
                                   std::vector<DuplTriInfo>& dupl_triangles, Labels& labels,
-                                  std::vector<phmap::flat_hash_set<uint>>& patches, cinolib::FOctree& octree,
+                                  std::vector<phmap::flat_hash_set<uint>>& patches, Broadphase& broadphase,
                                   const BoolOp &op, std::vector<double> &bool_coords, std::vector<uint> &bool_tris,
-                                  std::vector< std::bitset<NBIT>> &bool_labels)
+                                  std::vector< LabelSet> &bool_labels, PipelineStats *stats, PipelineControl *control)
 {
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+
     FastTrimesh tm(arr_verts, arr_out_tris, true);
+    if(stats)
+    {
+        stats->patches_time += lapTime(t);
+        stats->patches_peak_rss = peakRSS();
+        stats->patches_rss_delta += lapRSS(*stats);
+    }
+
+    if(!customInsideOutPipeline(tm, arr_verts, arr_in_tris, arr_in_labels, dupl_triangles, labels, patches, broadphase, stats, control))
+        return false;
+
+    t = std::chrono::steady_clock::now();
+
+    // booleand operations
+    uint num_tris_in_final_solution = applyBooleanOperation(tm, labels, op);
+    if(stats)
+    {
+        stats->selection_time = lapTime(t);
+        stats->selection_peak_rss = peakRSS();
+        stats->selection_rss_delta = lapRSS(*stats);
+    }
+    if(!stageCompleted(control, STAGE_SELECTION)) return false;
+
+    computeFinalExplicitResult(tm, labels, num_tris_in_final_solution, bool_coords, bool_tris, bool_labels, true);
+    if(stats)
+    {
+        stats->output_time = lapTime(t);
+        stats->output_peak_rss = peakRSS();
+        stats->output_rss_delta = lapRSS(*stats);
+        stats->num_output_tris = num_tris_in_final_solution;
+    }
+    return stageCompleted(control, STAGE_OUTPUT);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+/* patches and inside/outside labels only depend on the arrangement, so they can be computed once and
+ * reused to evaluate any boolean operation (see BooleanSession) */
+inline bool customInsideOutPipeline(FastTrimesh &tm, const std::vector<genericPoint*> &arr_verts, std::vector<uint> &arr_in_tris,
+                                    std::vector<LabelSet> &arr_in_labels, const std::vector<DuplTriInfo> &dupl_triangles,
+                                    Labels &labels, std::vector<phmap::flat_hash_set<uint>> &patches, Broadphase &broadphase,
+                                    PipelineStats *stats, PipelineControl *control)
+{
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
 
     computeAllPatches(tm, labels, patches, true);
 
+    if(stats)
+    {
+        stats->patches_time += lapTime(t);
+        stats->patches_peak_rss = peakRSS();
+        stats->patches_rss_delta += lapRSS(*stats);
+        stats->num_patches = static_cast<uint>(patches.size());
+        stats->patches_bytes = heap_bytes(patches);
+        for(const phmap::flat_hash_set<uint> &p : patches) stats->patches_bytes += hash_heap_bytes(p);
+    }
+    if(!stageCompleted(control, STAGE_PATCHES)) return false;
+
     // the informations about duplicated triangles (removed in arrangements) are restored in the original structures
-    addDuplicateTrisInfoInStructures(dupl_triangles, arr_in_tris, arr_in_labels, octree);
+    addDuplicateTrisInfoInStructures(dupl_triangles, arr_in_tris, arr_in_labels, broadphase);
 
-    // parse patches with octree and rays
-    cinolib::vec3d max_coords(octree.nodes[0].bbox.max.x() +0.5, octree.nodes[0].bbox.max.y() +0.5, octree.nodes[0].bbox.max.z() +0.5);
-    computeInsideOut(tm, patches, octree, arr_verts, arr_in_tris, arr_in_labels, max_coords, labels);
+    // parse patches with broadphase and rays
+    const cinolib::AABB &bbox = broadphase.bbox();
+    cinolib::vec3d max_coords(bbox.max.x() +0.5, bbox.max.y() +0.5, bbox.max.z() +0.5);
+    computeInsideOut(tm, patches, broadphase, arr_verts, arr_in_tris, arr_in_labels, max_coords, labels, stats, cancelFlag(control));
+    if(isCancelled(cancelFlag(control))) return false; // labels are incomplete
 
-    // booleand operations
-    uint num_tris_in_final_solution;
-    if(op == INTERSECTION)
-        num_tris_in_final_solution = boolIntersection(tm, labels);
-    else if(op == UNION)
-        num_tris_in_final_solution = boolUnion(tm, labels);
-    else if(op == SUBTRACTION)
-        num_tris_in_final_solution = boolSubtraction(tm, labels);
-    else if(op == XOR)
-        num_tris_in_final_solution = boolXOR(tm, labels);
-    else
+    if(stats)
     {
-        std::cerr << "boolean operation not implemented yet" << std::endl;
-        std::exit(EXIT_FAILURE);
+        stats->inside_out_time = lapTime(t);
+        stats->inside_out_peak_rss = peakRSS();
+        stats->inside_out_rss_delta = lapRSS(*stats);
+
+        stats->octree_bytes = broadphase.memoryUsage(); // including the duplicated triangles
+        stats->octree_nodes = broadphase.numNodes();
+        stats->octree_items = broadphase.numItems();
+
+        stats->labels_bytes = heap_bytes(labels.surface) + heap_bytes(labels.inside);
+        for(const LabelSet &l : labels.surface) stats->labels_bytes += l.heapBytes();
+        for(const LabelSet &l : labels.inside)  stats->labels_bytes += l.heapBytes();
     }
+    return stageCompleted(control, STAGE_INSIDE_OUT);
+}
 
-    computeFinalExplicitResult(tm, labels, num_tris_in_final_solution, bool_coords, bool_tris, bool_labels, true);
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint applyBooleanOperation(FastTrimesh &tm, const Labels &labels, const BoolOp &op)
+{
+    if(op == INTERSECTION)  return boolIntersection(tm, labels);
+    if(op == UNION)         return boolUnion(tm, labels);
+    if(op == SUBTRACTION)   return boolSubtraction(tm, labels);
+    if(op == XOR)           return boolXOR(tm, labels);
+
+    std::cerr << "boolean operation not implemented yet" << std::endl;
+    std::exit(EXIT_FAILURE);
 }
 
-inline void booleanPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
-                            const std::vector<uint> &in_labels, const BoolOp &op, std::vector<double> &bool_coords,
-                            std::vector<uint> &bool_tris, std::vector< std::bitset<NBIT> > &bool_labels)
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool customLabelingPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                                   const std::vector<uint> &in_labels, BooleanData &data, PipelineStats *stats,
+                                   PipelineControl *control, bool skip_same_label_pairs)
 {
     initFPU();
 
-    point_arena arena;
-    std::vector<genericPoint*> arr_verts; // <- it contains the original expl verts + the new_impl verts
-    std::vector<uint> arr_in_tris, arr_out_tris;
-    std::vector<std::bitset<NBIT>> arr_in_labels;
-    std::vector<DuplTriInfo> dupl_triangles;
-    Labels labels;
-    std::vector<phmap::flat_hash_set<uint>> patches;
-    cinolib::FOctree octree; // built with arr_in_tris and arr_in_labels
+    if(!data.broadphase) data.broadphase = makeBroadphase(defaultBroadphaseType());
 
-    customArrangementPipeline(in_coords, in_tris, in_labels, arr_in_tris, arr_in_labels, arena, arr_verts,
-                              arr_out_tris, labels, octree, dupl_triangles);
+    if(!customArrangementPipeline(in_coords, in_tris, in_labels, data.arr_in_tris, data.arr_in_labels, data.arena, data.arr_verts,
+                                  data.arr_out_tris, data.labels, *data.broadphase, data.dupl_triangles, stats, control, skip_same_label_pairs))
+        return false;
 
-    customBooleanPipeline(arr_verts, arr_in_tris, arr_out_tris, arr_in_labels, dupl_triangles, labels,
-                          patches, octree, op, bool_coords, bool_tris, bool_labels);
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+
+    data.tm = FastTrimesh(data.arr_verts, data.arr_out_tris, true);
+    if(stats)
+    {
+        stats->patches_time += lapTime(t);
+        stats->patches_peak_rss = peakRSS();
+        stats->patches_rss_delta += lapRSS(*stats);
+    }
+
+    return customInsideOutPipeline(data.tm, data.arr_verts, data.arr_in_tris, data.arr_in_labels, data.dupl_triangles,
+                                   data.labels, data.patches, *data.broadphase, stats, control);
 }
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-/* a custom arrangement pipeline in witch we can expose the octree used to find the starting intersection list */
-inline void customArrangementPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels,
-                                      std::vector<uint> &arr_in_tris, std::vector< std::bitset<NBIT>> &arr_in_labels,
+template<typename Select>
+inline bool customSelectionPipeline(const BooleanData &data, uint num_res, const Select &select,
+                                    std::vector<std::vector<double>> &bool_coords, std::vector<std::vector<uint>> &bool_tris,
+                                    std::vector<std::vector<LabelSet>> &bool_labels, PipelineStats *stats, PipelineControl *control)
+{
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+
+    // the selection masks do not touch the mesh, so the same data can be selected any number of times
+    std::vector<std::vector<uint8_t>> tri_masks(num_res);
+    std::vector<uint> num_tris_in_final_solution(num_res);
+    for(uint i = 0; i < num_res; i++)
+        num_tris_in_final_solution[i] = select(i, tri_masks[i]);
+
+    if(stats)
+    {
+        stats->selection_time = lapTime(t);
+        stats->selection_peak_rss = peakRSS();
+        stats->selection_rss_delta = lapRSS(*stats);
+    }
+    if(!stageCompleted(control, STAGE_SELECTION)) return false;
+
+    computeFinalExplicitResults(data.tm, data.labels, tri_masks, num_tris_in_final_solution, bool_coords, bool_tris, bool_labels);
+
+    if(stats)
+    {
+        stats->output_time = lapTime(t);
+        stats->output_peak_rss = peakRSS();
+        stats->output_rss_delta = lapRSS(*stats);
+        stats->num_output_tris = 0;
+        for(uint n : num_tris_in_final_solution) stats->num_output_tris += n;
+    }
+    return stageCompleted(control, STAGE_OUTPUT);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool booleanPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                            const std::vector<uint> &in_labels, const BoolOp &op, std::vector<double> &bool_coords,
+                            std::vector<uint> &bool_tris, std::vector< LabelSet > &bool_labels, PipelineStats *stats,
+                            PipelineControl *control, bool skip_same_label_pairs)
+{
+    std::vector<std::vector<double>> coords;
+    std::vector<std::vector<uint>> tris;
+    std::vector<std::vector<LabelSet>> tri_labels;
+
+    if(!booleanPipeline(in_coords, in_tris, in_labels, std::vector<BoolOp>{op}, coords, tris, tri_labels, stats, control,
+                        skip_same_label_pairs))
+        return false;
+
+    bool_coords.swap(coords[0]);
+    bool_tris.swap(tris[0]);
+    bool_labels.swap(tri_labels[0]);
+    return true;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+/* the arrangement and the inside/outside classification are computed once and shared by all the
+ * operations in ops. The i-th result is written in bool_coords[i], bool_tris[i] and bool_labels[i] */
+inline bool booleanPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                            const std::vector<uint> &in_labels, const std::vector<BoolOp> &ops,
+                            std::vector<std::vector<double>> &bool_coords, std::vector<std::vector<uint>> &bool_tris,
+                            std::vector<std::vector<LabelSet>> &bool_labels, PipelineStats *stats,
+                            PipelineControl *control, bool skip_same_label_pairs)
+{
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    setStageRange(control, STAGE_MERGE, STAGE_OUTPUT);
+
+    BooleanData data;
+    if(!customLabelingPipeline(in_coords, in_tris, in_labels, data, stats, control, skip_same_label_pairs))
+        return false;
+
+    if(!customSelectionPipeline(data, static_cast<uint>(ops.size()),
+                                [&](uint i, std::vector<uint8_t> &tri_mask){ return selectTriangles(data.labels, ops[i], tri_mask); },
+                                bool_coords, bool_tris, bool_labels, stats, control))
+        return false;
+
+    if(stats) stats->total_time = lapTime(t0);
+    return true;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+/* any CSG expression over the input labels costs a single arrangement and a single inside/outside
+ * classification, instead of one booleanPipeline call for each operation of the expression */
+inline bool booleanPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                            const std::vector<uint> &in_labels, const CSGExpression &expr, std::vector<double> &bool_coords,
+                            std::vector<uint> &bool_tris, std::vector< LabelSet > &bool_labels, PipelineStats *stats,
+                            PipelineControl *control, bool skip_same_label_pairs)
+{
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    setStageRange(control, STAGE_MERGE, STAGE_OUTPUT);
+
+    BooleanData data;
+    if(!customLabelingPipeline(in_coords, in_tris, in_labels, data, stats, control, skip_same_label_pairs))
+        return false;
+
+    std::vector<std::vector<double>> coords;
+    std::vector<std::vector<uint>> tris;
+    std::vector<std::vector<LabelSet>> tri_labels;
+    if(!customSelectionPipeline(data, 1,
+                                [&](uint, std::vector<uint8_t> &tri_mask){ return selectTriangles(data.labels, expr, tri_mask); },
+                                coords, tris, tri_labels, stats, control))
+        return false;
+
+    bool_coords.swap(coords[0]);
+    bool_tris.swap(tris[0]);
+    bool_labels.swap(tri_labels[0]);
+
+    if(stats) stats->total_time = lapTime(t0);
+    return true;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+/* a custom arrangement pipeline in witch we can expose the broadphase used to find the starting intersection list */
+inline bool customArrangementPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels,
+                                      std::vector<uint> &arr_in_tris, std::vector< LabelSet> &arr_in_labels,
                                       point_arena& arena, std::vector<genericPoint *> &vertices, std::vector<uint> &arr_out_tris, Labels &labels,
-                                      cinolib::FOctree &octree, std::vector<DuplTriInfo> &dupl_triangles)
+                                      Broadphase &broadphase, std::vector<DuplTriInfo> &dupl_triangles, PipelineStats *stats,
+                                      PipelineControl *control, bool skip_same_label_pairs)
 {
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+
+    if(stats)
+    {
+        *stats = PipelineStats(); // first stage of the pipeline
+        stats->rss = currentRSS();
+    }
+
     arr_in_labels.resize(in_labels.size());
-    std::bitset<NBIT> mask;
+    LabelSet mask;
 
     for(uint i = 0; i < in_labels.size(); i++)
     {
-        arr_in_labels[i][in_labels[i]] = true;
-        mask[in_labels[i]] = true;
+        arr_in_labels[i].set(in_labels[i]);
+        mask.set(in_labels[i]);
     }
 
     labels.num = mask.count();
+    labels.ids = mask;
 
     initFPU();
     double multiplier = computeMultiplier(in_coords);
 
     mergeDuplicatedVertices(in_coords, in_tris, arena, vertices, arr_in_tris, true);
+    if(stats)
+    {
+        stats->merge_time = lapTime(t);
+        stats->merge_peak_rss = peakRSS();
+        stats->merge_rss_delta = lapRSS(*stats);
+    }
+    if(!stageCompleted(control, STAGE_MERGE)) return false;
 
     customRemoveDegenerateAndDuplicatedTriangles(vertices, arr_in_tris, arr_in_labels, dupl_triangles, true);
+    if(stats)
+    {
+        stats->degenerate_removal_time = lapTime(t);
+        stats->degenerate_removal_peak_rss = peakRSS();
+        stats->degenerate_removal_rss_delta = lapRSS(*stats);
+    }
+    if(!stageCompleted(control, STAGE_DEGENERATE_REMOVAL)) return false;
 
     TriangleSoup ts(arena, vertices, arr_in_tris, arr_in_labels, multiplier, true);
+    if(stats)
+    {
+        stats->triangle_soup_time = lapTime(t);
+        stats->triangle_soup_peak_rss = peakRSS();
+        stats->triangle_soup_rss_delta = lapRSS(*stats);
+    }
+    if(!stageCompleted(control, STAGE_TRIANGLE_SOUP)) return false;
 
     AuxiliaryStructure g;
-    customDetectIntersections(ts, g.intersectionList(), octree);
+    // the inputs of a boolean are free of self-intersections, so only pairs from different meshes are tested
+    customDetectIntersections(ts, g.intersectionList(), broadphase, skip_same_label_pairs, stats, cancelFlag(control)); // build and broadphase times
+    if(!stageCompleted(control, STAGE_BROADPHASE)) return false;
+    t = std::chrono::steady_clock::now();
 
     g.initFromTriangleSoup(ts);
 
     classifyIntersections(ts, arena, g);
+    if(stats)
+    {
+        stats->classification_time = lapTime(t);
+        stats->classification_peak_rss = peakRSS();
+        stats->classification_rss_delta = lapRSS(*stats);
+    }
+    if(!stageCompleted(control, STAGE_CLASSIFICATION)) return false;
+
+    triangulation(ts, arena, g, arr_out_tris, labels.surface, cancelFlag(control));
+    if(isCancelled(cancelFlag(control))) return false; // some triangles have not been split
+
+    if(stats)
+    {
+        stats->triangulation_time = lapTime(t);
+        stats->triangulation_peak_rss = peakRSS();
+        stats->triangulation_rss_delta = lapRSS(*stats);
+    }
+
+    if(stats)
+    {
+        stats->num_input_verts = static_cast<uint>(in_coords.size() / 3);
+        stats->num_input_tris = static_cast<uint>(in_tris.size() / 3);
+        stats->num_intersecting_pairs = static_cast<uint>(g.intersectionList().size());
+        stats->num_arrangement_tris = static_cast<uint>(arr_out_tris.size() / 3);
+        stats->num_lpi_points = stats->num_tpi_points = stats->num_split_tris = 0;
+
+        for(const genericPoint *v : vertices)
+        {
+            if(v->isLPI()) stats->num_lpi_points++;
+            else if(v->isTPI()) stats->num_tpi_points++;
+        }
+
+        for(uint t_id = 0; t_id < ts.numTris(); t_id++)
+            if(g.triangleHasIntersections(t_id) || g.triangleHasCoplanars(t_id)) stats->num_split_tris++;
+
+        stats->aux_structure_bytes = g.memoryUsage();
+        stats->arena_bytes = arena.heap_bytes();
+        stats->arena_buckets = static_cast<uint>(arena.num_buckets());
+    }
 
-    triangulation(ts, arena, g, arr_out_tris, labels.surface);
     ts.appendJollyPoints();
 
     labels.inside.resize(arr_out_tris.size() / 3);
+
+    return stageCompleted(control, STAGE_TRIANGULATION);
 }
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 void customRemoveDegenerateAndDuplicatedTriangles(const std::vector<genericPoint *> &verts, std::vector<uint> &tris,
-                                                  std::vector<std::bitset<NBIT>> &labels, std::vector<DuplTriInfo> &dupl_triangles,
+                                                  std::vector<LabelSet> &labels, std::vector<DuplTriInfo> &dupl_triangles,
                                                   bool parallel)
 {
     if(parallel)
@@ -172,7 +480,7 @@ void customRemoveDegenerateAndDuplicatedTriangles(const std::vector<genericPoint
             uint v0_id = tris[(3 * t_id)];
             uint v1_id = tris[(3 * t_id) +1];
             uint v2_id = tris[(3 * t_id) +2];
-            std::bitset<NBIT> l = labels[t_id];
+            LabelSet l = labels[t_id];
 
             if(!colinear[t_id]) // good triangle
             {
@@ -199,7 +507,7 @@ void customRemoveDegenerateAndDuplicatedTriangles(const std::vector<genericPoint
                 {
                     uint orig_tri_off = ins.first->second.second;
 
-                    uint mesh_l = bitsetToUint(l);
+                    uint mesh_l = labelToUint(l);
                     assert(mesh_l >= 0);
 
                     uint curr_tri_verts[] = {v0_id, v1_id, v2_id};
@@ -228,7 +536,7 @@ void customRemoveDegenerateAndDuplicatedTriangles(const std::vector<genericPoint
             uint v0_id = tris[(3 * t_id)];
             uint v1_id = tris[(3 * t_id) +1];
             uint v2_id = tris[(3 * t_id) +2];
-            std::bitset<NBIT> l = labels[t_id];
+            LabelSet l = labels[t_id];
 
             if(!cinolib::points_are_colinear_3d(verts[v0_id]->toExplicit3D().ptr(),
                                                 verts[v1_id]->toExplicit3D().ptr(),
@@ -257,7 +565,7 @@ void customRemoveDegenerateAndDuplicatedTriangles(const std::vector<genericPoint
                 {
                     uint orig_tri_off = ins.first->second.second;
 
-                    uint mesh_l = bitsetToUint(l);
+                    uint mesh_l = labelToUint(l);
                     assert(mesh_l >= 0);
 
                     uint curr_tri_verts[] = {v0_id, v1_id, v2_id};
@@ -279,7 +587,8 @@ void customRemoveDegenerateAndDuplicatedTriangles(const std::vector<genericPoint
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::pair<uint, uint> > &intersection_list, cinolib::Octree &o)
+inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::pair<uint, uint> > &intersection_list, cinolib::Octree &o,
+                                      bool skip_same_label_pairs)
 {
     std::vector<cinolib::vec3d> verts(ts.numVerts());
 
@@ -288,18 +597,19 @@ inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::p
 
     o.build_from_vectors(verts, ts.trisVector());
 
-    intersection_list.reserve(ts.numTris());
-
-    tbb::spin_mutex mutex;
+    pair_buffers buffers; // one for each thread, no locks
     tbb::parallel_for((uint)0, (uint)o.leaves.size(), [&](uint i)
     {
         auto & leaf = o.leaves[i];
         if(leaf->item_indices.empty()) return;
+        std::vector<uint64_t> &local = buffers.local();
         for(uint j=0;   j<leaf->item_indices.size()-1; ++j)
             for(uint k=j+1; k<leaf->item_indices.size();   ++k)
             {
                 uint tid0 = leaf->item_indices[j];
                 uint tid1 = leaf->item_indices[k];
+                if(skip_same_label_pairs && ts.triLabel(tid0).intersects(ts.triLabel(tid1))) continue;
+
                 auto T0 = o.items[tid0];
                 auto T1 = o.items[tid1];
                 if(T0->aabb.intersects_box(T1->aabb)) // early reject based on AABB intersection
@@ -307,79 +617,127 @@ inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::p
                     const cinolib::Triangle *t0 = reinterpret_cast<cinolib::Triangle*>(T0);
                     const cinolib::Triangle *t1 = reinterpret_cast<cinolib::Triangle*>(T1);
                     if(t0->intersects_triangle(t1->v,true)) // precise check (exact if CINOLIB_USES_EXACT_PREDICATES is defined)
-                    {
-                        std::lock_guard<tbb::spin_mutex> guard(mutex);
-                        intersection_list.push_back(cinolib::unique_pair(tid0,tid1));
-                    }
+                        local.push_back(pack_pair(std::min(tid0, tid1), std::max(tid0, tid1)));
                 }
             }
     });
-    remove_duplicates(intersection_list);
+    merge_pair_buffers(buffers, intersection_list);
 }
 
-inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::pair<uint, uint> > &intersection_list, cinolib::FOctree &o)
+inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::pair<uint, uint> > &intersection_list, Broadphase &broadphase,
+                                      bool skip_same_label_pairs, PipelineStats *stats, const std::atomic<bool> *cancel)
 {
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+
     std::vector<cinolib::vec3d> verts(ts.numVerts());
 
     for(uint v_id = 0; v_id < ts.numVerts(); v_id++)
         verts[v_id] = cinolib::vec3d(ts.vertX(v_id), ts.vertY(v_id), ts.vertZ(v_id));
 
-    o.build_from_vectors(verts, ts.trisVector(), 100, 100, true);
-
-    struct ShewchukCache
-     {
-         double minor[3];
-         double perm[3];
-     };
-     std::vector<ShewchukCache> cache(o.items.size());
-     std::vector<bool> cached(o.items.size(),false);
+    if(broadphase.type() == BROADPHASE_DUAL)
+    {
+        // one tree for each input mesh. Triangles go with their lowest label, so the pairs in a tree always
+        // share a label and are skipped by TriTriVisitor anyway
+        std::vector<uint> groups(ts.numTris());
+        tbb::parallel_for((uint)0, ts.numTris(), [&](uint t_id){ groups[t_id] = ts.triLabel(t_id).first(); });
+        static_cast<DualTreeBroadphase &>(broadphase).setGroups(std::move(groups), skip_same_label_pairs);
+    }
 
-    intersection_list.reserve(ts.numTris());
+    // the index of a previous run (e.g. of a BooleanSession) is updated in place when only the vertices moved
+    bool refitted = broadphase.refit(verts, ts.trisVector());
+    if(!refitted) broadphase.build(verts, ts.trisVector());
+    if(stats)
+    {
+        stats->octree_time = lapTime(t);
+        stats->octree_refit = refitted ? 1 : 0;
+        stats->octree_peak_rss = peakRSS();
+        stats->octree_rss_delta = lapRSS(*stats);
+        if(broadphase.type() == BROADPHASE_OCTREE || broadphase.type() == BROADPHASE_MORTON)
+        {
+            OctreeParameters params = static_cast<const OctreeBroadphase &>(broadphase).parameters();
+            stats->octree_max_depth = params.max_depth;
+            stats->octree_items_per_leaf = params.items_per_leaf;
+        }
+    }
 
-    auto leaves = o.get_leaves();
+    // the exact tests only read the minors, computed here for all the triangles
+    broadphase.computeMinors();
 
-    tbb::spin_mutex mutex;
-    tbb::parallel_for((uint)0, (uint)leaves.size(), [&](uint i)
+    // exact test of the candidate pairs found by the broadphase that are not trivially disjoint
+    class TriTriVisitor : public PairVisitor
     {
-        auto leaf = &o.nodes[leaves[i]];
-        if(leaf->item_indices.empty()) return;
-        for(uint j=0;   j<leaf->item_indices.size()-1; ++j)
-            for(uint k=j+1; k<leaf->item_indices.size();   ++k)
+        public:
+
+            TriTriVisitor(const TriangleSoup &ts, Broadphase &broadphase, bool skip_same_label_pairs)
+                : ts(ts), broadphase(broadphase), skip_same_label_pairs(skip_same_label_pairs), filter(triTriFilter()) {}
+
+            struct Counts
             {
-                uint tid0 = leaf->item_indices[j];
-                uint tid1 = leaf->item_indices[k];
-                auto& T0 = o.items[tid0];
-                auto& T1 = o.items[tid1];
-                if(T0.aabb.intersects_box(T1.aabb)) // early reject based on AABB intersection
+                uint tests      = 0;
+                uint same_label = 0;
+                uint filtered   = 0;
+            };
+
+            void visit(uint tid0, uint tid1) override
+            {
+                Counts &local_counts = counts.local();
+                if(skip_same_label_pairs && ts.triLabel(tid0).intersects(ts.triLabel(tid1)))
                 {
-                    // update cache, if needed
-                    if(!cached[tid0])
-                    {
-                        cinolib::orient3d_get_minors(T0.v[0].ptr(), T0.v[1].ptr(), T0.v[2].ptr(), cache[tid0].minor, cache[tid0].perm);
-                        cached[tid0] = true;
-                    }
-                    if(!cached[tid1])
-                    {
-                        cinolib::orient3d_get_minors(T1.v[0].ptr(), T1.v[1].ptr(), T1.v[2].ptr(), cache[tid1].minor, cache[tid1].perm);
-                        cached[tid1] = true;
-                    }
-                    if(o.intersects_triangle(T0.v,T1.v,true,
-                                              cache[tid0].minor, cache[tid0].perm,
-                                              cache[tid1].minor, cache[tid1].perm)) // precise check (exact if CINOLIB_USES_EXACT_PREDICATES is defined)
-                    {
-                        std::lock_guard<tbb::spin_mutex> guard(mutex);
-                        intersection_list.push_back(cinolib::unique_pair(tid0,tid1));
-                    }
+                    local_counts.same_label++;
+                    return;
                 }
+
+                // most pairs are certified disjoint by the floating point plane test
+                if(filter && broadphase.itemsSeparated(tid0, tid1))
+                {
+                    local_counts.filtered++;
+                    return;
+                }
+                local_counts.tests++;
+
+                cinolib::vec3d T0[3], T1[3];
+                broadphase.itemVerts(tid0, T0);
+                broadphase.itemVerts(tid1, T1);
+
+                if(cinolib::FOctree::intersects_triangle(T0,T1,true,
+                                                         broadphase.itemMinor(tid0), broadphase.itemPerm(tid0),
+                                                         broadphase.itemMinor(tid1), broadphase.itemPerm(tid1))) // precise check (exact if CINOLIB_USES_EXACT_PREDICATES is defined)
+                    buffers.local().push_back(pack_pair(std::min(tid0, tid1), std::max(tid0, tid1)));
             }
-    });
-    remove_duplicates(intersection_list);
+
+            const TriangleSoup        &ts;
+            Broadphase                &broadphase;
+            bool                       skip_same_label_pairs;
+            bool                       filter;
+            pair_buffers               buffers; // one for each thread, no locks
+            tbb::enumerable_thread_specific<Counts> counts;
+    };
+
+    TriTriVisitor visitor(ts, broadphase, skip_same_label_pairs);
+    broadphase.visitOverlappingPairs(visitor, cancel);
+    merge_pair_buffers(visitor.buffers, intersection_list, false); // each pair is visited once, sorting is enough
+
+    if(stats)
+    {
+        stats->broadphase_time = lapTime(t);
+        stats->broadphase_peak_rss = peakRSS();
+        stats->broadphase_rss_delta = lapRSS(*stats);
+        stats->num_tri_tri_tests = 0;
+        stats->num_same_label_pairs = 0;
+        stats->num_filtered_pairs = 0;
+        for(const TriTriVisitor::Counts &c : visitor.counts)
+        {
+            stats->num_tri_tri_tests += c.tests;
+            stats->num_same_label_pairs += c.same_label;
+            stats->num_filtered_pairs += c.filtered;
+        }
+    }
 }
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 inline void addDuplicateTrisInfoInStructures(const std::vector<DuplTriInfo> &dupl_tris, std::vector<uint> &in_tris,
-                                             std::vector<std::bitset<NBIT>> &in_labels, cinolib::FOctree &octree)
+                                             std::vector<LabelSet> &in_labels, Broadphase &broadphase)
 {
     for(auto &item : dupl_tris)
     {
@@ -387,10 +745,7 @@ inline void addDuplicateTrisInfoInStructures(const std::vector<DuplTriInfo> &dup
         uint v1_id = in_tris[3 * item.t_id + 1];
         uint v2_id = in_tris[3 * item.t_id + 2];
 
-        std::bitset<NBIT> new_label;
-        new_label[item.l_id] = true;
-
-        const cinolib::Triangle &orig_tri = octree.items.at(item.t_id);
+        LabelSet new_label(item.l_id);
 
         uint new_t_id = in_tris.size() / 3;
 
@@ -399,18 +754,18 @@ inline void addDuplicateTrisInfoInStructures(const std::vector<DuplTriInfo> &dup
             in_tris.push_back(v0_id);
             in_tris.push_back(v1_id);
             in_tris.push_back(v2_id);
-            octree.items.emplace_back(new_t_id, orig_tri.v[0], orig_tri.v[1], orig_tri.v[2]);
+            broadphase.addItem(new_t_id, item.t_id, false);
         }
         else
         {
             in_tris.push_back(v0_id);
             in_tris.push_back(v2_id);
             in_tris.push_back(v1_id);
-            octree.items.emplace_back(new_t_id, orig_tri.v[0], orig_tri.v[2], orig_tri.v[1]);
+            broadphase.addItem(new_t_id, item.t_id, true);
         }
 
         in_labels.push_back(new_label); // we add the new_label to the new_triangle
-        in_labels[item.t_id][item.l_id] = false; // we remove the dupl label from the orig triangle
+        in_labels[item.t_id].reset(item.l_id); // we remove the dupl label from the orig triangle
     }
 }
 
@@ -448,7 +803,7 @@ inline void computeAllPatches(FastTrimesh &tm, const Labels &labels, std::vector
 
 inline void computeSinglePatch(FastTrimesh &tm, uint seed_t, const Labels &labels, phmap::flat_hash_set<uint> &patch)
 {
-    std::bitset<NBIT> ref_l = labels.surface[seed_t];
+    LabelSet ref_l = labels.surface[seed_t];
 
     std::stack<uint> tris_stack;
     tris_stack.push(seed_t);
@@ -486,7 +841,7 @@ inline void computeSinglePatch(FastTrimesh &tm, uint seed_t, const Labels &label
 
 inline void computeSinglePatch(FastTrimesh &tm, uint seed_t, const Labels &labels, phmap::flat_hash_set<uint> &patch, const std::vector<std::array<uint, 3>>& adjT2E)
 {
-    std::bitset<NBIT> ref_l = labels.surface[seed_t];
+    LabelSet ref_l = labels.surface[seed_t];
 
     std::stack<uint> tris_stack;
     tris_stack.push(seed_t);
@@ -597,58 +952,19 @@ inline void findRayEndpoints(const FastTrimesh &tm, const phmap::flat_hash_set<u
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline bool intersects_box(const cinolib::FOctree& tree, const cinolib::AABB & b, phmap::flat_hash_set<uint> & ids)
-{
-    auto root = &tree.nodes[0];
-    auto& items = tree.items;
-
-    std::stack<const cinolib::FOctreeNode*> lifo;
-    if(root && root->bbox.intersects_box(b))
-    {
-        lifo.push(root);
-    }
-
-    while(!lifo.empty())
-    {        
-        const cinolib::FOctreeNode *node = lifo.top();
-        lifo.pop();
-        assert(node->bbox.intersects_box(b));
-
-        if(node->is_inner)
-        {            
-            for(int i=0; i<8; ++i)
-            {
-                auto child = &tree.nodes[node->start + i];
-                if(child->bbox.intersects_box(b))
-                {
-                    lifo.push(child);
-                }
-            }
-        }
-        else
-        {
-            for(uint i : node->item_indices)
-            {
-                if(items[i].aabb.intersects_box(b))
-                {
-                    ids.insert(items[i].id);
-                }
-            }
-        }
-    }
-
-    return !ids.empty();
-}
-
-inline void computeInsideOut(const FastTrimesh &tm, const std::vector<phmap::flat_hash_set<uint>> &patches, const cinolib::FOctree &octree,
+inline void computeInsideOut(const FastTrimesh &tm, const std::vector<phmap::flat_hash_set<uint>> &patches, const Broadphase &broadphase,
                              const std::vector<genericPoint *> &in_verts, const std::vector<uint> &in_tris,
-                             const std::vector<std::bitset<NBIT>> &in_labels, const cinolib::vec3d &max_coords, Labels &labels)
+                             const std::vector<LabelSet> &in_labels, const cinolib::vec3d &max_coords, Labels &labels,
+                             PipelineStats *stats, const std::atomic<bool> *cancel)
 {
-    tbb::spin_mutex mutex;
+    std::atomic<uint> num_perturbations(0);
+
     tbb::parallel_for((uint)0, (uint)patches.size(), [&](uint p_id)
     {
+        if(isCancelled(cancel)) return;
+
         const phmap::flat_hash_set<uint> &patch_tris = patches[p_id];
-        const std::bitset<NBIT> &patch_surface_label = labels.surface[*patch_tris.begin()]; // label of the first triangle of the patch
+        const LabelSet &patch_surface_label = labels.surface[*patch_tris.begin()]; // label of the first triangle of the patch
 
         Ray ray;
         findRayEndpoints(tm, patch_tris, max_coords, ray);
@@ -658,26 +974,34 @@ inline void computeInsideOut(const FastTrimesh &tm, const std::vector<phmap::fla
         cinolib::AABB rayAABB(cinolib::vec3d(ray.v0.X(), ray.v0.Y(), ray.v0.Z()),
                               cinolib::vec3d(ray.v1.X(), ray.v1.Y(), ray.v1.Z()));
 
-        intersects_box(octree, rayAABB, tmp_inters);
+        broadphase.intersectsBox(rayAABB, tmp_inters);
 
         std::vector<uint> sorted_inters;
+        uint patch_perturbations = 0;
         pruneIntersectionsAndSortAlongRay(ray, in_verts, in_tris, in_labels, tmp_inters, patch_surface_label,
-                                          sorted_inters);
+                                          sorted_inters, patch_perturbations);
+        if(patch_perturbations > 0) num_perturbations += patch_perturbations;
 
-        std::bitset<NBIT> patch_inner_label;
+        LabelSet patch_inner_label;
         analyzeSortedIntersections(ray, in_verts, in_tris, in_labels, sorted_inters, patch_inner_label);
 
         propagateInnerLabelsOnPatch(patch_tris, patch_inner_label, labels);
     });
+
+    if(stats)
+    {
+        stats->num_rays = static_cast<uint>(patches.size()); // one ray for each patch
+        stats->num_ray_perturbations = num_perturbations;
+    }
 }
 
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 inline void pruneIntersectionsAndSortAlongRay(const Ray &ray, const std::vector<genericPoint*> &in_verts,
-                                              const std::vector<uint> &in_tris, const std::vector<std::bitset<NBIT>> &in_labels,
-                                              const phmap::flat_hash_set<uint> &tmp_inters, const std::bitset<NBIT> &patch_surface_label,
-                                              std::vector<uint> &inters_tris)
+                                              const std::vector<uint> &in_tris, const std::vector<LabelSet> &in_labels,
+                                              const phmap::flat_hash_set<uint> &tmp_inters, const LabelSet &patch_surface_label,
+                                              std::vector<uint> &inters_tris, uint &num_perturbations)
 {
     phmap::flat_hash_set<uint> visited_tri;
     visited_tri.reserve(tmp_inters.size()/6);
@@ -688,8 +1012,8 @@ inline void pruneIntersectionsAndSortAlongRay(const Ray &ray, const std::vector<
         ins = visited_tri.insert(t_id);
         if(!ins.second) continue; // triangle already analyzed or in the one ring of a vert or in the adj of an edge
 
-        const std::bitset<NBIT> tested_tri_label = in_labels[t_id];
-        uint uint_tri_label = bitsetToUint(tested_tri_label);
+        const LabelSet tested_tri_label = in_labels[t_id];
+        uint uint_tri_label = labelToUint(tested_tri_label);
         if(patch_surface_label[uint_tri_label]) continue; // <-- triangle of the same label of the tested patch
 
         const explicitPoint3D &tv0 = in_verts[in_tris[3 * t_id]]->toExplicit3D();
@@ -719,6 +1043,7 @@ inline void pruneIntersectionsAndSortAlongRay(const Ray &ray, const std::vector<
 
             int winner_tri = -1;
             winner_tri = perturbRayAndFindIntersTri(ray, in_verts, in_tris, vert_one_ring); // the first inters triangle after ray perturbation
+            num_perturbations++;
 
             if(winner_tri != -1)
                 inters_tris.push_back(winner_tri);
@@ -750,6 +1075,7 @@ inline void pruneIntersectionsAndSortAlongRay(const Ray &ray, const std::vector<
 
             int winner_tri = -1;
             winner_tri = perturbRayAndFindIntersTri(ray, in_verts, in_tris, edge_tris);
+            num_perturbations++;
 
             if(winner_tri != -1)
                 inters_tris.push_back(winner_tri);
@@ -767,14 +1093,14 @@ inline void pruneIntersectionsAndSortAlongRay(const Ray &ray, const std::vector<
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 inline void analyzeSortedIntersections(const Ray &ray, const std::vector<genericPoint*> &in_verts, const std::vector<uint> &in_tris,
-                                       const std::vector<std::bitset<NBIT>> &in_labels, const std::vector<uint> &sorted_inters,
-                                       std::bitset<NBIT> &patch_inner_label)
+                                       const std::vector<LabelSet> &in_labels, const std::vector<uint> &sorted_inters,
+                                       LabelSet &patch_inner_label)
 {
-    std::bitset<NBIT> visited_labels;
+    LabelSet visited_labels;
 
     for(uint t_id : sorted_inters)
     {
-        uint t_label = bitsetToUint(in_labels[t_id]);
+        uint t_label = labelToUint(in_labels[t_id]);
         if(visited_labels[t_label]) continue; // already visited patch
 
         const explicitPoint3D &tv0 = in_verts[in_tris[3 * t_id]]->toExplicit3D();
@@ -782,9 +1108,9 @@ inline void analyzeSortedIntersections(const Ray &ray, const std::vector<generic
         const explicitPoint3D &tv2 = in_verts[in_tris[3 * t_id +2]]->toExplicit3D();
 
         if(checkTriangleOrientation(ray, tv0, tv1, tv2) == 1) // checkOrientation -> 1 if inside, 0 if outside
-            patch_inner_label[t_label] = true;
+            patch_inner_label.set(t_label);
 
-        visited_labels[t_label] = true;
+        visited_labels.set(t_label);
     }
 }
 
@@ -800,8 +1126,8 @@ inline bool triContainsVert(uint t_id, uint v_id, const std::vector<uint> &in_tr
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline void findVertRingTris(uint v_id, const std::bitset<NBIT> &ref_label, const phmap::flat_hash_set<uint> &inters_tris,
-                             const std::vector<uint> &in_tris, const std::vector<std::bitset<NBIT>> &in_labels,
+inline void findVertRingTris(uint v_id, const LabelSet &ref_label, const phmap::flat_hash_set<uint> &inters_tris,
+                             const std::vector<uint> &in_tris, const std::vector<LabelSet> &in_labels,
                              std::vector<uint> &one_ring)
 {
     for(uint t_id : inters_tris)
@@ -813,8 +1139,8 @@ inline void findVertRingTris(uint v_id, const std::bitset<NBIT> &ref_label, cons
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline void findEdgeTris(uint ev0_id, uint ev1_id, const std::bitset<NBIT> &ref_label, const phmap::flat_hash_set<uint> &inters_tris,
-                         const std::vector<uint> &in_tris, const std::vector<std::bitset<NBIT>> &in_labels,
+inline void findEdgeTris(uint ev0_id, uint ev1_id, const LabelSet &ref_label, const phmap::flat_hash_set<uint> &inters_tris,
+                         const std::vector<uint> &in_tris, const std::vector<LabelSet> &in_labels,
                          std::vector<uint> &edge_tris)
 {
     for(auto t_id : inters_tris)
@@ -1352,7 +1678,7 @@ inline uint checkTriangleOrientation(const Ray &ray, const explicitPoint3D &tv0,
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline void propagateInnerLabelsOnPatch(const phmap::flat_hash_set<uint> &patch_tris, const std::bitset<NBIT> &patch_inner_label, Labels &labels)
+inline void propagateInnerLabelsOnPatch(const phmap::flat_hash_set<uint> &patch_tris, const LabelSet &patch_inner_label, Labels &labels)
 {
     for(uint t_id : patch_tris)
         labels.inside[t_id] = patch_inner_label;
@@ -1360,45 +1686,77 @@ inline void propagateInnerLabelsOnPatch(const phmap::flat_hash_set<uint> &patch_
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
+inline void packLabels(Labels &labels)
+{
+    // the ids are not necessarily contiguous: the width depends on the largest one
+    uint num_bits = labels.ids.any() ? labels.ids.last() + 1 : 0;
+
+    if(num_bits == 0 || num_bits > 64) return; // ids from 64 on -> the selection works on the sparse label sets
+    if(labels.packed8.surface.size()  == labels.surface.size() && labels.packed8.all  != 0) return; // already packed
+    if(labels.packed16.surface.size() == labels.surface.size() && labels.packed16.all != 0) return;
+    if(labels.packed32.surface.size() == labels.surface.size() && labels.packed32.all != 0) return;
+    if(labels.packed64.surface.size() == labels.surface.size() && labels.packed64.all != 0) return;
+
+    if(num_bits <= 8)       packLabels(labels, labels.packed8);
+    else if(num_bits <= 16) packLabels(labels, labels.packed16);
+    else if(num_bits <= 32) packLabels(labels, labels.packed32);
+    else                    packLabels(labels, labels.packed64);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+template<typename T>
+inline void packLabels(const Labels &labels, PackedLabels<T> &packed)
+{
+    packLabels(labels.surface, packed.surface);
+    packLabels(labels.inside,  packed.inside);
+
+    packed.all = 0;
+    for(uint l : labels.ids) packed.all |= static_cast<T>(T(1) << l);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+template<typename T>
+inline void packLabels(const std::vector<LabelSet> &labels, std::vector<T> &packed)
+{
+    packed.resize(labels.size());
+
+    tbb::parallel_for((uint)0, (uint)labels.size(), [&](uint t_id)
+    {
+        T mask = 0;
+        for(uint l : labels[t_id])
+        {
+            assert(l < 8 * sizeof(T) && "label does not fit in the packed mask");
+            mask |= static_cast<T>(T(1) << l);
+        }
+        packed[t_id] = mask;
+    });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
 inline void computeFinalExplicitResult(const FastTrimesh &tm, const Labels &labels, uint num_tris_in_final_res,
                                        std::vector<double> &out_coords, std::vector<uint> &out_tris, 
-                                       std::vector<std::bitset<NBIT>> &out_label, bool flat_array)
+                                       std::vector<LabelSet> &out_label, bool flat_array)
 {
     if(flat_array)
     {
-        // loop over triangles and fix vertex indices
-        uint num_vertices = 0;
-        std::vector<int>  vertex_index(tm.numVerts(), -1);
-        out_tris.resize(3 * num_tris_in_final_res);
-        out_label.resize(num_tris_in_final_res);
-        uint tri_offset = 0;
-        for(uint t_id = 0; t_id < tm.numTris(); t_id++)
+        // the triangles of the result (already flipped) are the ones with info = 1
+        std::vector<std::vector<uint8_t>> tri_masks(1, std::vector<uint8_t>(tm.numTris()));
+        tbb::parallel_for((uint)0, tm.numTris(), [&](uint t_id)
         {
-            if(tm.triInfo(t_id) == 0) continue; // triangle not included in final version
-            const uint *triangle = tm.tri(t_id);
-            for(uint i = 0; i < 3; i++)
-            {
-                uint old_vertex = triangle[i];
-                if (vertex_index[old_vertex] == -1) {
-                    vertex_index[old_vertex] = num_vertices ++;
-                }
-                out_tris[3 * tri_offset + i] = vertex_index[old_vertex];
-            }
-            out_label[tri_offset] = labels.surface[t_id];
-            tri_offset++;
-        }
+            tri_masks[0][t_id] = (tm.triInfo(t_id) == 0) ? TRI_DISCARD : TRI_KEEP;
+        });
 
-        // loop over vertices
-        out_coords.resize(3 * num_vertices);
-        for(uint v_id = 0; v_id < (uint)tm.numVerts(); v_id++) {
-            if (vertex_index[v_id] == -1) continue;
-            double* v = out_coords.data() + (3 * vertex_index[v_id]);
-            tm.vert(v_id)->getApproxXYZCoordinates(v[0], v[1], v[2]);
-        }
+        std::vector<std::vector<double>> coords;
+        std::vector<std::vector<uint>> tris;
+        std::vector<std::vector<LabelSet>> tri_labels;
+        computeFinalExplicitResults(tm, labels, tri_masks, {num_tris_in_final_res}, coords, tris, tri_labels);
 
-        // rescale output
-        double multiplier = tm.vert(tm.numVerts() - 1)->toExplicit3D().X();
-        for(double &c : out_coords) c /= multiplier;
+        out_coords.swap(coords[0]);
+        out_tris.swap(tris[0]);
+        out_label.swap(tri_labels[0]);
     } else
     {
         out_coords.reserve(3 * 3 * num_tris_in_final_res);
@@ -1442,19 +1800,123 @@ inline void computeFinalExplicitResult(const FastTrimesh &tm, const Labels &labe
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline uint boolIntersection(FastTrimesh &tm, const Labels &labels)
+/* same as computeFinalExplicitResult(..., flat_array = true), but the triangles are selected (and flipped)
+ * by a selection mask instead of the triangle infos, so the mesh is not modified. Several results can be
+ * extracted at once: the approximate coordinates of the vertices are computed once for all of them */
+inline void computeFinalExplicitResults(const FastTrimesh &tm, const Labels &labels, const std::vector<std::vector<uint8_t>> &tri_masks,
+                                        const std::vector<uint> &num_tris_in_final_res, std::vector<std::vector<double>> &out_coords,
+                                        std::vector<std::vector<uint>> &out_tris, std::vector<std::vector<LabelSet>> &out_labels)
 {
-    uint num_tris_in_final_solution = 0;
-    tm.resetTrianglesInfo();
+    assert(tri_masks.size() == num_tris_in_final_res.size());
+
+    uint num_res = static_cast<uint>(tri_masks.size());
+    out_coords.resize(num_res);
+    out_tris.resize(num_res);
+    out_labels.resize(num_res);
 
-    for(uint t_id = 0; t_id < tm.numTris(); t_id++)
+    // a vertex is in a result if one of its triangles is. Each vertex only reads the triangles around it,
+    // so that the vertices can be marked in parallel without writing the same flag twice
+    auto in_result = [&](uint v_id, const std::vector<uint8_t> &tri_mask)
     {
-        if((labels.surface[t_id] ^ labels.inside[t_id]).count() == labels.num) // triangle to keep
+        for(uint e_id : tm.adjV2E(v_id))
+            for(uint t_id : tm.adjE2T(e_id))
+                if(tri_mask[t_id] & TRI_KEEP) return true;
+        return false;
+    };
+
+    // vertices used by at least one result
+    std::vector<uint8_t> vert_used(tm.numVerts(), 0);
+    tbb::parallel_for((uint)0, tm.numVerts(), [&](uint v_id)
+    {
+        for(const std::vector<uint8_t> &tri_mask : tri_masks)
         {
-            tm.setTriInfo(t_id, 1);
-            num_tris_in_final_solution++;
+            if(!in_result(v_id, tri_mask)) continue;
+            vert_used[v_id] = 1;
+            break;
         }
+    });
+
+    // approximate (and rescaled) coordinates, shared by all the results
+    double multiplier = tm.vert(tm.numVerts() - 1)->toExplicit3D().X();
+    std::vector<double> approx_coords(3 * tm.numVerts());
+    tbb::parallel_for((uint)0, tm.numVerts(), [&](uint v_id)
+    {
+        if(!vert_used[v_id]) return;
+        double *v = approx_coords.data() + (3 * v_id);
+        tm.vert(v_id)->getApproxXYZCoordinates(v[0], v[1], v[2]);
+        v[0] /= multiplier;
+        v[1] /= multiplier;
+        v[2] /= multiplier;
+    });
+
+    std::vector<uint> tri_offset(tm.numTris());
+    std::vector<uint> vertex_index(tm.numVerts());
+    for(uint r_id = 0; r_id < num_res; r_id++)
+    {
+        const std::vector<uint8_t> &tri_mask = tri_masks[r_id];
+
+        // position of each triangle in the result (prefix sum of the kept triangles)
+        tbb::parallel_scan(tbb::blocked_range<uint>(0, tm.numTris()), (uint)0,
+        [&](const tbb::blocked_range<uint> &r, uint sum, bool is_final_scan)
+        {
+            for(uint t_id = r.begin(); t_id < r.end(); t_id++)
+            {
+                if(is_final_scan) tri_offset[t_id] = sum;
+                sum += (tri_mask[t_id] & TRI_KEEP) ? 1 : 0;
+            }
+            return sum;
+        }, std::plus<uint>());
+
+        // vertices of the result, numbered in order of id (prefix sum of the used vertices)
+        tbb::parallel_for((uint)0, tm.numVerts(), [&](uint v_id)
+        {
+            vertex_index[v_id] = (vert_used[v_id] && in_result(v_id, tri_mask)) ? 1 : 0;
+        });
+
+        uint num_vertices = tbb::parallel_scan(tbb::blocked_range<uint>(0, tm.numVerts()), (uint)0,
+        [&](const tbb::blocked_range<uint> &r, uint sum, bool is_final_scan)
+        {
+            for(uint v_id = r.begin(); v_id < r.end(); v_id++)
+            {
+                uint used = vertex_index[v_id];
+                if(is_final_scan) vertex_index[v_id] = used ? sum : UINT_MAX;
+                sum += used;
+            }
+            return sum;
+        }, std::plus<uint>());
+
+        assert(tm.numTris() == 0 || tri_offset.back() + ((tri_mask.back() & TRI_KEEP) ? 1 : 0) == num_tris_in_final_res[r_id]);
+
+        out_tris[r_id].resize(3 * num_tris_in_final_res[r_id]);
+        out_labels[r_id].resize(num_tris_in_final_res[r_id]);
+        tbb::parallel_for((uint)0, tm.numTris(), [&](uint t_id)
+        {
+            if(!(tri_mask[t_id] & TRI_KEEP)) return; // triangle not included in final version
+            const uint *triangle = tm.tri(t_id);
+            const bool flip = tri_mask[t_id] & TRI_FLIP;
+            uint *out_t = out_tris[r_id].data() + (3 * tri_offset[t_id]);
+            for(uint i = 0; i < 3; i++)
+                out_t[i] = vertex_index[triangle[flip ? 2 - i : i]]; // same order of FastTrimesh::flipTri
+
+            out_labels[r_id][tri_offset[t_id]] = labels.surface[t_id];
+        });
+
+        out_coords[r_id].resize(3 * num_vertices);
+        tbb::parallel_for((uint)0, tm.numVerts(), [&](uint v_id)
+        {
+            if(vertex_index[v_id] == UINT_MAX) return;
+            std::copy_n(approx_coords.data() + (3 * v_id), 3, out_coords[r_id].data() + (3 * vertex_index[v_id]));
+        });
     }
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint boolIntersection(FastTrimesh &tm, const Labels &labels)
+{
+    std::vector<uint8_t> tri_mask;
+    uint num_tris_in_final_solution = selectTriangles(labels, INTERSECTION, tri_mask);
+    applyTriSelection(tm, tri_mask);
 
     return num_tris_in_final_solution;
 }
@@ -1463,17 +1925,9 @@ inline uint boolIntersection(FastTrimesh &tm, const Labels &labels)
 
 inline uint boolUnion(FastTrimesh &tm, const Labels &labels)
 {
-    uint num_tris_in_final_solution = 0;
-    tm.resetTrianglesInfo();
-
-    for(uint t_id = 0; t_id < tm.numTris(); t_id++)
-    {
-        if(labels.inside[t_id].count() == 0) // triangle to keep
-        {
-            tm.setTriInfo(t_id, 1);
-            num_tris_in_final_solution++;
-        }
-    }
+    std::vector<uint8_t> tri_mask;
+    uint num_tris_in_final_solution = selectTriangles(labels, UNION, tri_mask);
+    applyTriSelection(tm, tri_mask);
 
     return num_tris_in_final_solution;
 }
@@ -1482,69 +1936,228 @@ inline uint boolUnion(FastTrimesh &tm, const Labels &labels)
 // if more than 2 models -> model 0 - all the others
 inline uint boolSubtraction(FastTrimesh &tm, const Labels &labels)
 {
-    uint num_tris_in_final_solution = 0;
-    tm.resetTrianglesInfo();
+    std::vector<uint8_t> tri_mask;
+    uint num_tris_in_final_solution = selectTriangles(labels, SUBTRACTION, tri_mask);
+    applyTriSelection(tm, tri_mask);
 
-    for(uint t_id = 0; t_id < tm.numTris(); t_id++)
+    return num_tris_in_final_solution;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint boolXOR(FastTrimesh &tm, const Labels &labels)
+{
+    std::vector<uint8_t> tri_mask;
+    uint num_tris_in_final_solution = selectTriangles(labels, XOR, tri_mask);
+    applyTriSelection(tm, tri_mask);
+
+    return num_tris_in_final_solution;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint8_t boolTriSelection(const Labels &labels, uint t_id, const BoolOp &op)
+{
+    const LabelSet &surface = labels.surface[t_id];
+    const LabelSet &inside  = labels.inside[t_id];
+
+    switch(op)
     {
-        if(labels.surface[t_id][0] && labels.inside[t_id].count() == 0) // triangle to keep
+        case INTERSECTION:
         {
-            tm.setTriInfo(t_id, 1);
-            num_tris_in_final_solution++;
-        }
-        else if(!labels.surface[t_id][0] && labels.inside[t_id][0] && labels.inside[t_id].count() == 1)
+            if((surface ^ inside).count() == labels.num) return TRI_KEEP;
+        } break;
+
+        case UNION:
         {
-            tm.setTriInfo(t_id, 1);
-            num_tris_in_final_solution++;
+            if(inside.count() == 0) return TRI_KEEP;
+        } break;
+
+        case SUBTRACTION: // if more than 2 models -> model 0 - all the others
+        {
+            if(surface[0] && inside.count() == 0) return TRI_KEEP;
+            if(!surface[0] && inside[0] && inside.count() == 1) return TRI_KEEP | TRI_FLIP;
+        } break;
+
+        case XOR:
+        {
+            if(inside.count() == 0) return TRI_KEEP;
+            if((surface ^ inside).count() == labels.num) return TRI_KEEP | TRI_FLIP;
+        } break;
+
+        default:
+        {
+            std::cerr << "boolean operation not implemented yet" << std::endl;
+            std::exit(EXIT_FAILURE);
         }
     }
 
-    //fix triangles orientation
-    for(uint t_id = 0; t_id < tm.numTris(); t_id++)
-    {
-        if(tm.triInfo(t_id) == 1 && labels.surface[t_id][0] != 1)
-            tm.flipTri(t_id);
-    }
+    return TRI_DISCARD;
+}
 
-    return num_tris_in_final_solution;
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint selectTriangles(Labels &labels, const BoolOp &op, std::vector<uint8_t> &tri_mask)
+{
+    packLabels(labels); // only the first selection packs them
+    return selectTriangles(static_cast<const Labels &>(labels), op, tri_mask);
 }
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline uint boolXOR(FastTrimesh &tm, const Labels &labels)
+inline uint selectTriangles(const Labels &labels, const BoolOp &op, std::vector<uint8_t> &tri_mask)
 {
-    uint num_tris_in_final_solution = 0;
-    tm.resetTrianglesInfo();
+    uint num_tris = static_cast<uint>(labels.surface.size());
+
+    if(labels.packed8.all  != 0 && labels.packed8.surface.size()  == num_tris) return selectTrianglesPacked(labels.packed8,  op, tri_mask);
+    if(labels.packed16.all != 0 && labels.packed16.surface.size() == num_tris) return selectTrianglesPacked(labels.packed16, op, tri_mask);
+    if(labels.packed32.all != 0 && labels.packed32.surface.size() == num_tris) return selectTrianglesPacked(labels.packed32, op, tri_mask);
+    if(labels.packed64.all != 0 && labels.packed64.surface.size() == num_tris) return selectTrianglesPacked(labels.packed64, op, tri_mask);
 
-    for(uint t_id = 0; t_id < tm.numTris(); t_id++)
+    // label ids from 64 on (or labels not packed) -> sparse label sets
+    tri_mask.resize(num_tris);
+
+    return tbb::parallel_reduce(tbb::blocked_range<uint>(0, num_tris), (uint)0,
+    [&](const tbb::blocked_range<uint> &r, uint num_tris_in_final_solution)
     {
-        if((labels.inside[t_id].count() == 0) || ((labels.surface[t_id] ^ labels.inside[t_id]).count() == labels.num)) // triangle to keep
+        for(uint t_id = r.begin(); t_id < r.end(); t_id++)
         {
-            tm.setTriInfo(t_id, 1);
-            num_tris_in_final_solution++;
+            tri_mask[t_id] = boolTriSelection(labels, t_id, op);
+            num_tris_in_final_solution += (tri_mask[t_id] & TRI_KEEP) ? 1 : 0;
         }
-    }
+        return num_tris_in_final_solution;
+    }, std::plus<uint>());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+/* same selection of boolTriSelection, done on the packed labels. The loops are branchless, so that the
+ * compiler can vectorize them, and the mask and the number of selected triangles are computed together */
+template<typename T>
+inline uint selectTrianglesPacked(const PackedLabels<T> &packed, const BoolOp &op, std::vector<uint8_t> &tri_mask)
+{
+    uint num_tris = static_cast<uint>(packed.surface.size());
+    tri_mask.resize(num_tris);
+
+    const T all = packed.all; // (surface ^ inside) has all the labels <=> its count is labels.num
+    const T *surface = packed.surface.data();
+    const T *inside  = packed.inside.data();
+    uint8_t *mask    = tri_mask.data();
 
-    // fix triangles orientation
-    for(uint t_id = 0; t_id < tm.numTris(); t_id++)
+    if(op != INTERSECTION && op != UNION && op != SUBTRACTION && op != XOR)
     {
-        if(tm.triInfo(t_id) == 1 && labels.inside[t_id].count() > 0)
-            tm.flipTri(t_id);
+        std::cerr << "boolean operation not implemented yet" << std::endl;
+        std::exit(EXIT_FAILURE);
     }
 
-    return num_tris_in_final_solution;
+    return tbb::parallel_reduce(tbb::blocked_range<uint>(0, num_tris, 4096), (uint)0,
+    [&](const tbb::blocked_range<uint> &r, uint num_tris_in_final_solution)
+    {
+        const uint b = r.begin(), e = r.end();
+        switch(op)
+        {
+            case INTERSECTION:
+            {
+                for(uint t_id = b; t_id < e; t_id++)
+                {
+                    uint8_t keep = ((surface[t_id] ^ inside[t_id]) == all);
+                    mask[t_id] = keep * TRI_KEEP;
+                    num_tris_in_final_solution += keep;
+                }
+            } break;
+
+            case UNION:
+            {
+                for(uint t_id = b; t_id < e; t_id++)
+                {
+                    uint8_t keep = (inside[t_id] == 0);
+                    mask[t_id] = keep * TRI_KEEP;
+                    num_tris_in_final_solution += keep;
+                }
+            } break;
+
+            case SUBTRACTION: // if more than 2 models -> model 0 - all the others
+            {
+                for(uint t_id = b; t_id < e; t_id++)
+                {
+                    uint8_t in_0 = (surface[t_id] & 1);
+                    uint8_t keep = in_0 & (inside[t_id] == 0);
+                    uint8_t flip = (in_0 ^ 1) & (inside[t_id] == 1);
+                    mask[t_id] = (keep | flip) * TRI_KEEP + flip * TRI_FLIP;
+                    num_tris_in_final_solution += keep | flip;
+                }
+            } break;
+
+            case XOR:
+            {
+                for(uint t_id = b; t_id < e; t_id++)
+                {
+                    uint8_t keep = (inside[t_id] == 0);
+                    uint8_t flip = (keep ^ 1) & ((surface[t_id] ^ inside[t_id]) == all);
+                    mask[t_id] = (keep | flip) * TRI_KEEP + flip * TRI_FLIP;
+                    num_tris_in_final_solution += keep | flip;
+                }
+            } break;
+
+            default: break;
+        }
+        return num_tris_in_final_solution;
+    }, std::plus<uint>());
 }
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline uint bitsetToUint(const bitset<NBIT> &b)
+inline uint8_t csgTriSelection(const Labels &labels, uint t_id, const CSGExpression &expr)
 {
-    assert(b.count() == 1 && "more than 1 bit set to 1");
+    /* the triangle bounds the meshes in its surface label: just behind it a point is inside those meshes
+     * and the ones in its inside label, just in front of it (normal side) only inside the latter */
+    bool behind   = expr.contains(labels.surface[t_id] | labels.inside[t_id]);
+    bool in_front = expr.contains(labels.inside[t_id]);
+
+    if(behind == in_front) return TRI_DISCARD; // the result is on both sides or on none of them
+    if(in_front)           return TRI_KEEP | TRI_FLIP;
+    return TRI_KEEP;
+}
 
-    for(uint i = 0; i < NBIT; i++)
-        if (b[i]) return i;
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint selectTriangles(const Labels &labels, const CSGExpression &expr, std::vector<uint8_t> &tri_mask)
+{
+    uint num_tris = static_cast<uint>(labels.surface.size());
+    tri_mask.resize(num_tris);
+
+    return tbb::parallel_reduce(tbb::blocked_range<uint>(0, num_tris), (uint)0,
+    [&](const tbb::blocked_range<uint> &r, uint num_tris_in_final_solution)
+    {
+        for(uint t_id = r.begin(); t_id < r.end(); t_id++)
+        {
+            tri_mask[t_id] = csgTriSelection(labels, t_id, expr);
+            num_tris_in_final_solution += (tri_mask[t_id] & TRI_KEEP) ? 1 : 0;
+        }
+        return num_tris_in_final_solution;
+    }, std::plus<uint>());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void applyTriSelection(FastTrimesh &tm, const std::vector<uint8_t> &tri_mask)
+{
+    assert(tri_mask.size() == tm.numTris());
 
-    return 0; //warning killer
+    tbb::parallel_for((uint)0, tm.numTris(), [&](uint t_id)
+    {
+        tm.setTriInfo(t_id, (tri_mask[t_id] & TRI_KEEP) ? 1 : 0);
+        if(tri_mask[t_id] & TRI_FLIP) tm.flipTri(t_id);
+    });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint labelToUint(const LabelSet &b)
+{
+    assert(b.count() == 1 && "more than 1 label");
+
+    return b.first();
 }
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -1562,10 +2175,9 @@ bool consistentWinding(const uint *t0, const uint *t1) // t0 -> vertex ids of tr
 
 /// :::::::::::::: DEBUG :::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline std::string printBitset(const std::bitset<NBIT> &b, uint num_label)
+inline std::string printBitset(const LabelSet &b, uint num_label)
 {
-    std::string s = b.to_string();
-    s = s.substr(b.size()-num_label, b.size());
+    std::string s = b.to_string(num_label);
     std::cerr << s << std::endl;
 
     return s;
@@ -1574,7 +2186,7 @@ inline std::string printBitset(const std::bitset<NBIT> &b, uint num_label)
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline void saveOutputWithLabels(const std::string &filename, cinolib::Trimesh<> &m, const std::vector<std::bitset<NBIT> > &labels)
+inline void saveOutputWithLabels(const std::string &filename, cinolib::Trimesh<> &m, const std::vector<LabelSet > &labels)
 {
     std::vector<double> coords(3 * m.num_verts());
     for(uint v_id = 0; v_id < m.num_verts(); v_id++)
@@ -1584,11 +2196,16 @@ inline void saveOutputWithLabels(const std::string &filename, cinolib::Trimesh<>
         coords[3 * v_id +2] = m.vert(v_id).z();
     }
 
+    // cinolib stores one int per triangle, i.e. the mask of labels 0..30
     std::vector<int> int_labels(m.num_polys());
     for(uint t_id = 0; t_id < m.num_polys(); t_id++)
     {
-        int l = static_cast<int>(labels[t_id].to_ulong());
-        int_labels[t_id] = l;
+        if(labels[t_id].any() && labels[t_id].last() >= 8 * sizeof(int) - 1)
+        {
+            std::cerr << "ERROR : " << __FILE__ << ", line " << __LINE__ << " : saveOutputWithLabels() : label " << labels[t_id].last() << " can't be stored in the file " << filename << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        int_labels[t_id] = static_cast<int>(labels[t_id].to_ulong());
     }
 
     cinolib::write_OBJ(filename.c_str(), coords, m.vector_polys(), int_labels);
@@ -1596,7 +2213,7 @@ inline void saveOutputWithLabels(const std::string &filename, cinolib::Trimesh<>
 
 //:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline void loadInputWithLabels(const string &filename, std::vector<double> &coords, std::vector<uint> &tris, std::vector< std::bitset<NBIT> > &labels)
+inline void loadInputWithLabels(const string &filename, std::vector<double> &coords, std::vector<uint> &tris, std::vector< LabelSet > &labels)
 {
     cinolib::Trimesh<> m(filename.c_str());
     m.poly_label_wrt_color();
@@ -1618,7 +2235,7 @@ inline void loadInputWithLabels(const string &filename, std::vector<double> &coo
         tris.push_back(m.poly_vert_id(t_id, 1));
         tris.push_back(m.poly_vert_id(t_id, 2));
 
-        std::bitset<NBIT> l(static_cast<unsigned long>(m.poly_data(t_id).label));
+        LabelSet l = LabelSet::fromUlong(static_cast<unsigned long>(m.poly_data(t_id).label));
         labels.push_back(l);
     }
 }
@@ -43,15 +43,38 @@
 #include "triangle_soup.h"
 #include "intersection_classification.h"
 #include "triangulation.h"
-#include "foctree.h"
+#include "octree_broadphase.h"
+#include "bvh.h"
+#include "dual_tree_broadphase.h"
+#include "csg_expression.h"
+#include "pipeline_stats.h"
+#include "pipeline_control.h"
 
-#include <bitset>
+#include <memory>
+
+
+// surface and inside labels stored as contiguous bit masks (bit i -> label i)
+template<typename T>
+struct PackedLabels
+{
+    std::vector<T> surface;
+    std::vector<T> inside;
+    T              all = 0; // bits of the labels of the input meshes
+};
 
 struct Labels
 {
-    std::vector< std::bitset<NBIT> > surface;
-    std::vector< std::bitset<NBIT> > inside;
-    uint num;
+    std::vector< LabelSet > surface;
+    std::vector< LabelSet > inside;
+    uint num;     // number of input meshes
+    LabelSet ids; // labels of the input meshes, not necessarily 0..num-1
+
+    // packed copy of surface and inside, filled by the first selection of a boolean operation (see packLabels).
+    // Only the narrowest mask able to store the largest label id is filled, none of them if there are ids from 64 on
+    PackedLabels<uint8_t>  packed8;
+    PackedLabels<uint16_t> packed16;
+    PackedLabels<uint32_t> packed32;
+    PackedLabels<uint64_t> packed64;
 };
 
 struct Ray
@@ -69,8 +92,26 @@ struct DuplTriInfo
     bool w;
 };
 
+// arrangement of the input meshes with its patches and inside/outside labels, i.e. everything the boolean
+// operations are selected from (see customLabelingPipeline). The vertices point into the arena, so it can't be copied
+struct BooleanData
+{
+    point_arena                             arena;
+    std::vector<genericPoint*>              arr_verts; // <- it contains the original expl verts + the new_impl verts
+    std::vector<uint>                       arr_in_tris;
+    std::vector<uint>                       arr_out_tris;
+    std::vector<LabelSet>                   arr_in_labels;
+    std::vector<DuplTriInfo>                dupl_triangles;
+    Labels                                  labels;
+    std::vector<phmap::flat_hash_set<uint>> patches;
+    std::unique_ptr<Broadphase>             broadphase; // built with arr_in_tris and arr_in_labels
+    FastTrimesh                             tm;
+};
+
 enum BoolOp {UNION, INTERSECTION, SUBTRACTION, XOR, NONE};
 
+enum TriSelection {TRI_DISCARD = 0, TRI_KEEP = 1, TRI_FLIP = 2}; // bits of the per-triangle selection mask
+
 enum IntersInfo {DISCARD, NO_INT, INT_IN_V0, INT_IN_V1, INT_IN_V2, INT_IN_EDGE01, INT_IN_EDGE12, INT_IN_EDGE20, INT_IN_TRI};
 
 struct less_than_GP_on_X // lessThan GenericPoint along X
@@ -97,32 +138,84 @@ struct less_than_GP_on_Z // lessThan GenericPoint along Z
     }
 };
 
-inline void customBooleanPipeline(std::vector<genericPoint*>& arr_verts, std::vector<uint>& arr_in_tris,
-                                  std::vector<uint>& arr_out_tris, std::vector<std::bitset<NBIT>>& arr_in_labels,
-                                  std::vector<DuplTriInfo>& dupl_triangles, Labels& labels,
-                                  std::vector<phmap::flat_hash_set<uint>>& patches, cinolib::FOctree& octree,
-                                  const BoolOp &op, std::vector<double> &bool_coords, std::vector<uint> &bool_tris,
-                                  std::vector< std::bitset<NBIT>> &bool_labels);
+// backend of the broadphase built by the pipeline functions, BROADPHASE_OCTREE unless changed
+inline void setDefaultBroadphaseType(BroadphaseType type);
+inline BroadphaseType defaultBroadphaseType();
 
-inline void booleanPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
-                            const std::vector<uint> &in_labels, const BoolOp &op, std::vector<double> &bool_coords,
-                            std::vector<uint> &bool_tris, std::vector< std::bitset<NBIT> > &bool_labels);
+inline std::unique_ptr<Broadphase> makeBroadphase(BroadphaseType type);
 
+// floating point filter of the pairs tested by customDetectIntersections (see Broadphase::itemsSeparated), on unless
+// changed. The intersections are the same without it, only slower to find: it is turned off to check the filter
+inline void setTriTriFilter(bool enabled);
+inline bool triTriFilter();
 
-inline void customArrangementPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels,
-                                      std::vector<uint> &arr_in_tris, std::vector< std::bitset<NBIT>> &arr_in_labels,
+// the pipeline functions return false if the run has been cancelled through control (see PipelineControl)
+inline bool customBooleanPipeline(std::vector<genericPoint*>& arr_verts, std::vector<uint>& arr_in_tris,
+                                  std::vector<uint>& arr_out_tris, std::vector<LabelSet>& arr_in_labels,
+                                  std::vector<DuplTriInfo>& dupl_triangles, Labels& labels,
+                                  std::vector<phmap::flat_hash_set<uint>>& patches, Broadphase& broadphase,
+                                  const BoolOp &op, std::vector<double> &bool_coords, std::vector<uint> &bool_tris,
+                                  std::vector< LabelSet> &bool_labels, PipelineStats *stats = nullptr,
+                                  PipelineControl *control = nullptr);
+
+inline bool customInsideOutPipeline(FastTrimesh &tm, const std::vector<genericPoint*> &arr_verts, std::vector<uint> &arr_in_tris,
+                                    std::vector<LabelSet> &arr_in_labels, const std::vector<DuplTriInfo> &dupl_triangles,
+                                    Labels &labels, std::vector<phmap::flat_hash_set<uint>> &patches, Broadphase &broadphase,
+                                    PipelineStats *stats = nullptr, PipelineControl *control = nullptr);
+
+inline uint applyBooleanOperation(FastTrimesh &tm, const Labels &labels, const BoolOp &op);
+
+// the stages shared by booleanPipeline and BooleanSession::init: arrangement, patches and inside/outside labels.
+// data.broadphase is created with the default type if null, otherwise it is reused (refitted if possible)
+inline bool customLabelingPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                                   const std::vector<uint> &in_labels, BooleanData &data, PipelineStats *stats = nullptr,
+                                   PipelineControl *control = nullptr, bool skip_same_label_pairs = true);
+
+// selection and output stages of num_res results: select(i, tri_mask) fills the selection mask of the i-th
+// result and returns its number of triangles
+template<typename Select>
+inline bool customSelectionPipeline(const BooleanData &data, uint num_res, const Select &select,
+                                    std::vector<std::vector<double>> &bool_coords, std::vector<std::vector<uint>> &bool_tris,
+                                    std::vector<std::vector<LabelSet>> &bool_labels, PipelineStats *stats = nullptr,
+                                    PipelineControl *control = nullptr);
+
+// skip_same_label_pairs is passed to customDetectIntersections: turn it off for inputs with
+// self-intersecting meshes, which fail mesh_booleans_inputcheck
+inline bool booleanPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                            const std::vector<uint> &in_labels, const BoolOp &op, std::vector<double> &bool_coords,
+                            std::vector<uint> &bool_tris, std::vector< LabelSet > &bool_labels, PipelineStats *stats = nullptr,
+                            PipelineControl *control = nullptr, bool skip_same_label_pairs = true);
+
+inline bool booleanPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                            const std::vector<uint> &in_labels, const std::vector<BoolOp> &ops,
+                            std::vector<std::vector<double>> &bool_coords, std::vector<std::vector<uint>> &bool_tris,
+                            std::vector<std::vector<LabelSet>> &bool_labels, PipelineStats *stats = nullptr,
+                            PipelineControl *control = nullptr, bool skip_same_label_pairs = true);
+
+inline bool booleanPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris,
+                            const std::vector<uint> &in_labels, const CSGExpression &expr, std::vector<double> &bool_coords,
+                            std::vector<uint> &bool_tris, std::vector< LabelSet > &bool_labels, PipelineStats *stats = nullptr,
+                            PipelineControl *control = nullptr, bool skip_same_label_pairs = true);
+
+inline bool customArrangementPipeline(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels,
+                                      std::vector<uint> &arr_in_tris, std::vector< LabelSet> &arr_in_labels,
                                       point_arena& arena, std::vector<genericPoint *> &vertices, std::vector<uint> &arr_out_tris, Labels &labels,
-                                      cinolib::FOctree &octree, std::vector<DuplTriInfo> &dupl_triangles);
+                                      Broadphase &broadphase, std::vector<DuplTriInfo> &dupl_triangles, PipelineStats *stats = nullptr,
+                                      PipelineControl *control = nullptr, bool skip_same_label_pairs = true);
 
 inline void customRemoveDegenerateAndDuplicatedTriangles(const std::vector<genericPoint*> &verts, std::vector<uint> &tris,
-                                                         std::vector< std::bitset<NBIT> > &labels, std::vector<DuplTriInfo> &dupl_triangles,
+                                                         std::vector< LabelSet > &labels, std::vector<DuplTriInfo> &dupl_triangles,
                                                          bool parallel);
 
-inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::pair<uint, uint> > &intersection_list, cinolib::Octree &o);
-inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::pair<uint, uint> > &intersection_list, cinolib::FOctree &o);
+// with skip_same_label_pairs, triangles sharing a label (i.e. an input mesh) are not tested against each other.
+// Valid only if the input meshes are free of self-intersections, as required by the boolean pipeline
+inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::pair<uint, uint> > &intersection_list, cinolib::Octree &o,
+                                      bool skip_same_label_pairs);
+inline void customDetectIntersections(const TriangleSoup &ts, std::vector<std::pair<uint, uint> > &intersection_list, Broadphase &broadphase,
+                                      bool skip_same_label_pairs, PipelineStats *stats = nullptr, const std::atomic<bool> *cancel = nullptr);
 
 inline void addDuplicateTrisInfoInStructures(const std::vector<DuplTriInfo> &dupl_tris, std::vector<uint> &in_tris,
-                                             std::vector<std::bitset<NBIT>> &in_labels, cinolib::FOctree &octree);
+                                             std::vector<LabelSet> &in_labels, Broadphase &broadphase);
 
 inline void computeAllPatches(FastTrimesh &tm, const Labels &labels, std::vector<phmap::flat_hash_set<uint>> &patches, bool parallel);
 
@@ -131,29 +224,28 @@ inline void computeSinglePatch(FastTrimesh &tm, uint seed_t, const Labels &label
 
 inline void findRayEndpoints(const FastTrimesh &tm, const phmap::flat_hash_set<uint> &patch, const cinolib::vec3d &max_coords, Ray &ray);
 
-inline bool intersects_box(const cinolib::FOctree& tree, const cinolib::AABB & b, phmap::flat_hash_set<uint> & ids);
-
-inline void computeInsideOut(const FastTrimesh &tm, const std::vector<phmap::flat_hash_set<uint>> &patches, const cinolib::FOctree &octree,
+inline void computeInsideOut(const FastTrimesh &tm, const std::vector<phmap::flat_hash_set<uint>> &patches, const Broadphase &broadphase,
                              const std::vector<genericPoint *> &in_verts, const std::vector<uint> &in_tris,
-                             const std::vector<std::bitset<NBIT>> &in_labels, const cinolib::vec3d &max_coords, Labels &labels);
+                             const std::vector<LabelSet> &in_labels, const cinolib::vec3d &max_coords, Labels &labels,
+                             PipelineStats *stats = nullptr, const std::atomic<bool> *cancel = nullptr);
 
 inline void pruneIntersectionsAndSortAlongRay(const Ray &ray, const std::vector<genericPoint*> &in_verts,
-                                              const std::vector<uint> &in_tris, const std::vector<std::bitset<NBIT>> &in_labels,
-                                              const phmap::flat_hash_set<uint> &tmp_inters, const std::bitset<NBIT> &patch_surface_label,
-                                              std::vector<uint> &inters_tris);
+                                              const std::vector<uint> &in_tris, const std::vector<LabelSet> &in_labels,
+                                              const phmap::flat_hash_set<uint> &tmp_inters, const LabelSet &patch_surface_label,
+                                              std::vector<uint> &inters_tris, uint &num_perturbations);
 
 inline void analyzeSortedIntersections(const Ray &ray, const std::vector<genericPoint*> &in_verts, const std::vector<uint> &in_tris,
-                                       const std::vector<std::bitset<NBIT>> &in_labels, const std::vector<uint> &sorted_inters,
-                                       std::bitset<NBIT> &patch_inner_label);
+                                       const std::vector<LabelSet> &in_labels, const std::vector<uint> &sorted_inters,
+                                       LabelSet &patch_inner_label);
 
 inline bool triContainsVert(uint t_id, uint v_id, const std::vector<uint> &in_tris);
 
-inline void findVertRingTris(uint v_id, const std::bitset<NBIT> &ref_label, const phmap::flat_hash_set<uint> &inters_tris,
-                             const std::vector<uint> &in_tris, const std::vector<std::bitset<NBIT>> &in_labels,
+inline void findVertRingTris(uint v_id, const LabelSet &ref_label, const phmap::flat_hash_set<uint> &inters_tris,
+                             const std::vector<uint> &in_tris, const std::vector<LabelSet> &in_labels,
                              std::vector<uint> &one_ring);
 
-inline void findEdgeTris(uint ev0_id, uint ev1_id, const std::bitset<NBIT> &ref_label, const phmap::flat_hash_set<uint> &inters_tris,
-                             const std::vector<uint> &in_tris, const std::vector<std::bitset<NBIT>> &in_labels,
+inline void findEdgeTris(uint ev0_id, uint ev1_id, const LabelSet &ref_label, const phmap::flat_hash_set<uint> &inters_tris,
+                             const std::vector<uint> &in_tris, const std::vector<LabelSet> &in_labels,
                              std::vector<uint> &edge_tris);
 
 inline Ray perturbXRay(const Ray &ray, uint offset);
@@ -182,10 +274,22 @@ inline void sortIntersectedTrisAlongZ(const Ray &ray, const std::vector<genericP
 
 inline uint checkTriangleOrientation(const Ray &ray, const explicitPoint3D &tv0, const explicitPoint3D &tv1, const explicitPoint3D &tv2);
 
-inline void propagateInnerLabelsOnPatch(const phmap::flat_hash_set<uint> &patch_tris, const std::bitset<NBIT> &patch_inner_label, Labels &labels);
+inline void propagateInnerLabelsOnPatch(const phmap::flat_hash_set<uint> &patch_tris, const LabelSet &patch_inner_label, Labels &labels);
+
+inline void packLabels(Labels &labels); // does nothing if the labels are already packed
+
+template<typename T>
+inline void packLabels(const Labels &labels, PackedLabels<T> &packed);
+
+template<typename T>
+inline void packLabels(const std::vector<LabelSet> &labels, std::vector<T> &packed);
 
 inline void computeFinalExplicitResult(const FastTrimesh &tm, const Labels &labels, uint num_tris_in_final_res,
-                                       std::vector<double> &out_coords, std::vector<uint> &out_tris, std::vector<std::bitset<NBIT>> &out_label, bool flat_array);
+                                       std::vector<double> &out_coords, std::vector<uint> &out_tris, std::vector<LabelSet> &out_label, bool flat_array);
+
+inline void computeFinalExplicitResults(const FastTrimesh &tm, const Labels &labels, const std::vector<std::vector<uint8_t>> &tri_masks,
+                                        const std::vector<uint> &num_tris_in_final_res, std::vector<std::vector<double>> &out_coords,
+                                        std::vector<std::vector<uint>> &out_tris, std::vector<std::vector<LabelSet>> &out_labels);
 
 inline uint boolIntersection(FastTrimesh &tm, const Labels &labels);
 
@@ -195,17 +299,34 @@ inline uint boolSubtraction(FastTrimesh &tm, const Labels &labels);
 
 inline uint boolXOR(FastTrimesh &tm, const Labels &labels);
 
-inline uint bitsetToUint(const std::bitset<NBIT> &b);
+inline uint8_t boolTriSelection(const Labels &labels, uint t_id, const BoolOp &op);
+
+// packs the labels first, so that this and the following selections run on the packed masks
+inline uint selectTriangles(Labels &labels, const BoolOp &op, std::vector<uint8_t> &tri_mask);
+
+// uses the packed masks if already there, the sparse label sets otherwise
+inline uint selectTriangles(const Labels &labels, const BoolOp &op, std::vector<uint8_t> &tri_mask);
+
+template<typename T>
+inline uint selectTrianglesPacked(const PackedLabels<T> &packed, const BoolOp &op, std::vector<uint8_t> &tri_mask);
+
+inline uint8_t csgTriSelection(const Labels &labels, uint t_id, const CSGExpression &expr);
+
+inline uint selectTriangles(const Labels &labels, const CSGExpression &expr, std::vector<uint8_t> &tri_mask);
+
+inline void applyTriSelection(FastTrimesh &tm, const std::vector<uint8_t> &tri_mask);
+
+inline uint labelToUint(const LabelSet &b);
 
 inline bool consistentWinding(const uint *t0, const uint *t1);
 
 /// :::::::::::::: DEBUG :::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-inline std::string printBitset(const std::bitset<NBIT> &b, uint num_label); // just for debug
+inline std::string printBitset(const LabelSet &b, uint num_label); // just for debug
 
-inline void saveOutputWithLabels(const std::string &filename, cinolib::Trimesh<> &m, const std::vector<std::bitset<NBIT>> &labels);
+inline void saveOutputWithLabels(const std::string &filename, cinolib::Trimesh<> &m, const std::vector<LabelSet> &labels);
 
-inline void loadInputWithLabels(const std::string &filename, std::vector<double> &coords, std::vector<uint> &tris, std::vector<std::bitset<NBIT> > &labels);
+inline void loadInputWithLabels(const std::string &filename, std::vector<double> &coords, std::vector<uint> &tris, std::vector<LabelSet > &labels);
 
 inline void loadInputWithLabels(const std::string &filename, std::vector<double> &coords, std::vector<uint> &tris, std::vector<uint> &labels);
 
@@ -0,0 +1,239 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "broadphase.h"
+
+#include <cinolib/predicates.h>
+#include <cmath>
+#include <tbb/tbb.h>
+
+inline void Broadphase::addItem(uint id, uint orig_id, bool flip)
+{
+    assert(id == numItems());
+    bool update_minors = hasMinors();
+    uint v0 = tris[3 * orig_id], v1 = tris[3 * orig_id + 1], v2 = tris[3 * orig_id + 2];
+    tris.push_back(v0);
+    tris.push_back(flip ? v2 : v1);
+    tris.push_back(flip ? v1 : v2);
+    boxes.push_back(boxes[orig_id]);
+
+    if(update_minors)
+    {
+        cinolib::vec3d v[3];
+        itemVerts(id, v);
+        minors.resize(minors.size() + 3);
+        perms.resize(perms.size() + 3);
+        cinolib::orient3d_get_minors(v[0].ptr(), v[1].ptr(), v[2].ptr(), itemMinor(id), itemPerm(id));
+    }
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline const cinolib::AABB &Broadphase::itemBox(uint id) const
+{
+    return boxes[id];
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void Broadphase::itemVerts(uint id, cinolib::vec3d v[3]) const
+{
+    v[0] = verts[tris[3 * id]];
+    v[1] = verts[tris[3 * id + 1]];
+    v[2] = verts[tris[3 * id + 2]];
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint Broadphase::numItems() const
+{
+    return static_cast<uint>(boxes.size());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void Broadphase::computeMinors()
+{
+    minors.resize(3 * boxes.size());
+    perms.resize(3 * boxes.size());
+    tbb::parallel_for((uint)0, numItems(), [&](uint i)
+    {
+        cinolib::vec3d v[3];
+        itemVerts(i, v);
+        cinolib::orient3d_get_minors(v[0].ptr(), v[1].ptr(), v[2].ptr(), itemMinor(i), itemPerm(i));
+    });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool Broadphase::hasMinors() const
+{
+    return !boxes.empty() && minors.size() == 3 * boxes.size();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline double *Broadphase::itemMinor(uint id)
+{
+    return minors.data() + 3 * id;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline double *Broadphase::itemPerm(uint id)
+{
+    return perms.data() + 3 * id;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void Broadphase::initItems(const std::vector<cinolib::vec3d> &in_verts, const std::vector<uint> &in_tris)
+{
+    verts = in_verts;
+    tris  = in_tris;
+    minors.clear();
+    perms.clear();
+    boxes.resize(tris.size() / 3);
+    num_indexed = numItems();
+    tbb::parallel_for((uint)0, static_cast<uint>(boxes.size()), [&](uint i)
+    {
+        cinolib::AABB &b = boxes[i];
+        b.reset();
+        b.push(verts.at(tris[3 * i]));
+        b.push(verts.at(tris[3 * i + 1]));
+        b.push(verts.at(tris[3 * i + 2]));
+    });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool Broadphase::itemsSeparated(uint id0, uint id1) const
+{
+    assert(hasMinors());
+    return planeSeparates(id0, id1) || planeSeparates(id1, id0);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool Broadphase::planeSeparates(uint plane_id, uint id) const
+{
+    const double o3derrboundA = 7.7715611723761027e-16; // (7 + 56 eps) eps, as in orient3d_with_cached_minors
+
+    // same operations of orient3d_with_cached_minors(v, t0, t1, t2) for each vertex v of item id
+    const double *m = &minors[3 * plane_id];
+    const double *p = &perms[3 * plane_id];
+    const cinolib::vec3d &d = verts[tris[3 * plane_id + 2]];
+
+    double det[3], err[3];
+    for(uint i = 0; i < 3; i++)
+    {
+        const cinolib::vec3d &a = verts[tris[3 * id + i]];
+        double adx = a.x() - d.x(), ady = a.y() - d.y(), adz = a.z() - d.z();
+        det[i] = adx * m[0] + ady * m[1] + adz * m[2];
+        err[i] = o3derrboundA * (std::fabs(adx) * p[0] + std::fabs(ady) * p[1] + std::fabs(adz) * p[2]);
+    }
+
+    return ( det[0] > err[0] &&  det[1] > err[1] &&  det[2] > err[2]) ||
+           (-det[0] > err[0] && -det[1] > err[1] && -det[2] > err[2]);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool Broadphase::refitItems(const std::vector<cinolib::vec3d> &in_verts, const std::vector<uint> &in_tris, std::vector<uint> &moved)
+{
+    if(num_indexed == 0 || in_tris.size() != 3 * num_indexed) return false;
+
+    verts = in_verts;
+    tris  = in_tris;
+    boxes.resize(num_indexed);
+    minors.clear();
+    perms.clear();
+
+    tbb::enumerable_thread_specific<std::vector<uint>> local_moved;
+    tbb::parallel_for((uint)0, num_indexed, [&](uint i)
+    {
+        cinolib::AABB b;
+        b.push(verts.at(tris[3 * i]));
+        b.push(verts.at(tris[3 * i + 1]));
+        b.push(verts.at(tris[3 * i + 2]));
+        if(b.min.x() != boxes[i].min.x() || b.min.y() != boxes[i].min.y() || b.min.z() != boxes[i].min.z() ||
+           b.max.x() != boxes[i].max.x() || b.max.y() != boxes[i].max.y() || b.max.z() != boxes[i].max.z())
+        {
+            boxes[i] = b;
+            local_moved.local().push_back(i);
+        }
+    });
+
+    moved.clear();
+    for(const std::vector<uint> &l : local_moved) moved.insert(moved.end(), l.begin(), l.end());
+    tbb::parallel_sort(moved.begin(), moved.end());
+    return true;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline size_t Broadphase::itemsMemoryUsage() const
+{
+    return verts.capacity() * sizeof(cinolib::vec3d) + tris.capacity() * sizeof(uint) + boxes.capacity() * sizeof(cinolib::AABB) +
+           (minors.capacity() + perms.capacity()) * sizeof(double);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline const char *broadphaseName(BroadphaseType type)
+{
+    switch(type)
+    {
+        case BROADPHASE_OCTREE: return "octree";
+        case BROADPHASE_MORTON: return "morton";
+        case BROADPHASE_BVH:    return "bvh";
+        case BROADPHASE_DUAL:   return "dual";
+    }
+    return "unknown";
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool parseBroadphaseType(const std::string &name, BroadphaseType &type)
+{
+    if(name == "octree")      type = BROADPHASE_OCTREE;
+    else if(name == "morton") type = BROADPHASE_MORTON;
+    else if(name == "bvh")    type = BROADPHASE_BVH;
+    else if(name == "dual")   type = BROADPHASE_DUAL;
+    else return false;
+    return true;
+}
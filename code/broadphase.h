@@ -0,0 +1,152 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_BROADPHASE_H
+#define EXACT_BOOLEANS_BROADPHASE_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cinolib/geometry/aabb.h>
+
+#include "../arrangements/external/parallel-hashmap/parallel_hashmap/phmap.h"
+
+enum BroadphaseType {BROADPHASE_OCTREE, BROADPHASE_MORTON, BROADPHASE_BVH, BROADPHASE_DUAL};
+
+// receives the candidate pairs of Broadphase::visitOverlappingPairs
+class PairVisitor
+{
+    public:
+
+        virtual ~PairVisitor() {}
+
+        // called concurrently, exactly once for each unordered pair of items with overlapping AABBs
+        virtual void visit(uint id0, uint id1) = 0;
+};
+
+/* Spatial index over the triangles of the arrangement input, used both to find the candidate pairs of
+ * customDetectIntersections and to collect the triangles crossed by the rays of computeInsideOut.
+ * Item ids are triangle ids. All backends return the same pairs and the same query results, they only
+ * differ in build and traversal times (see makeBroadphase in booleans.h). The only exception is
+ * DualTreeBroadphase, that can skip the pairs of items in the same input mesh
+*/
+
+class Broadphase
+{
+    public:
+
+        virtual ~Broadphase() {}
+
+        virtual BroadphaseType type() const = 0;
+
+        // one item for each triangle of tris
+        virtual void build(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris) = 0;
+
+        // updates the index of the last build for the new vertices verts, with the same number of triangles.
+        // Items keep their ids, and the index is only updated where their AABBs changed (e.g. the moving
+        // mesh of an animation), rebuilding the parts that would get too slow to query. Returns false if
+        // the index can't be refitted (e.g. a different number of triangles): build must be called then
+        virtual bool refit(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris) = 0;
+
+        virtual void visitOverlappingPairs(PairVisitor &visitor, const std::atomic<bool> *cancel = nullptr) const = 0;
+
+        // collects the ids of the indexed items having an AABB that intersects b
+        virtual bool intersectsBox(const cinolib::AABB &b, phmap::flat_hash_set<uint> &ids) const = 0;
+
+        // appends an item that is not indexed, e.g. the copy of a duplicated triangle: same vertices of
+        // item orig_id, with the opposite winding if flip is true. id must be numItems()
+        inline void addItem(uint id, uint orig_id, bool flip);
+
+        inline const cinolib::AABB &itemBox(uint id) const;
+
+        // copies the three vertices of item id in v
+        inline void itemVerts(uint id, cinolib::vec3d v[3]) const;
+
+        inline uint numItems() const;
+
+        // orient3d minors and error bound factors of each item (see cinolib::orient3d_get_minors), so that
+        // the exact triangle-triangle tests only read them. computeMinors fills them in parallel for all
+        // the items, addItem keeps them up to date afterwards. Both point to the 3 values of item id
+        inline void computeMinors();
+        inline bool hasMinors() const;
+        inline double *itemMinor(uint id);
+        inline double *itemPerm(uint id);
+
+        // true if the plane of one item has all the vertices of the other strictly on one side, so that
+        // they can't intersect. The orientations are evaluated in floating point from the minors, and only
+        // trusted when above the static error bound of orient3d: false means the exact test is needed
+        inline bool itemsSeparated(uint id0, uint id1) const;
+
+        virtual uint numNodes() const = 0;
+
+        virtual size_t memoryUsage() const = 0; // approximate heap bytes of items and nodes
+
+        // AABB of the indexed items, enlarged by 1.5 as the octree root
+        inline const cinolib::AABB &bbox() const { return box; }
+
+    protected:
+
+        // copies the input of build, computing the AABB of each item
+        inline void initItems(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris);
+
+        inline size_t itemsMemoryUsage() const;
+
+        // true if the vertices of item id are certainly on the same side of the plane of item plane_id
+        inline bool planeSeparates(uint plane_id, uint id) const;
+
+        // copies the input of refit if it has as many triangles as the last build, dropping the items added
+        // afterwards. Returns the (sorted) ids of the items having a different AABB in moved
+        inline bool refitItems(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris, std::vector<uint> &moved);
+
+        // items are stored as vertex ids plus bounds, the backends only index them
+        std::vector<cinolib::vec3d> verts;
+        std::vector<uint>           tris;  // three vertex ids for each item
+        std::vector<cinolib::AABB>  boxes; // AABB of each item
+        std::vector<double>         minors; // 3 for each item, empty until computeMinors
+        std::vector<double>         perms;  // 3 for each item, empty until computeMinors
+        cinolib::AABB               box;
+        uint                        num_indexed = 0; // items of the last build, the following ones are added by addItem
+};
+
+inline const char *broadphaseName(BroadphaseType type);
+
+// "octree", "morton", "bvh" or "dual", returns false for any other name
+inline bool parseBroadphaseType(const std::string &name, BroadphaseType &type);
+
+#include "broadphase.cpp"
+
+#endif // EXACT_BOOLEANS_BROADPHASE_H
@@ -0,0 +1,520 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "bvh.h"
+#include "pipeline_control.h"
+
+#include <tbb/tbb.h>
+
+#define BVH_NUM_BINS            16
+#define BVH_MIN_LEAF_SIZE       4    // smaller nodes are never split
+#define BVH_PARALLEL_BUILD_SIZE 4096 // smaller ranges are built by a single task
+#define BVH_PARALLEL_DEPTH      10   // deeper nodes are traversed by a single task
+#define BVH_REFIT_MAX_GROWTH    2.0  // subtrees growing more than this are built again by refit
+
+inline double halfSurfaceArea(const cinolib::AABB &b)
+{
+    cinolib::vec3d d = b.delta();
+    return d.x() * d.y() + d.y() * d.z() + d.z() * d.x();
+}
+
+// same as AABB::push, but inlined and safe for empty (reset) boxes
+inline void growBox(cinolib::AABB &b, const cinolib::vec3d &min, const cinolib::vec3d &max)
+{
+    for(uint i = 0; i < 3; i++)
+    {
+        b.min[i] = std::min(b.min[i], min[i]);
+        b.max[i] = std::max(b.max[i], max[i]);
+    }
+}
+
+inline void growBox(cinolib::AABB &b, const cinolib::AABB &src)
+{
+    growBox(b, src.min, src.max);
+}
+
+inline void growBox(cinolib::AABB &b, const cinolib::vec3d &p)
+{
+    growBox(b, p, p);
+}
+
+struct BVHBins
+{
+    cinolib::AABB bbox[BVH_NUM_BINS];  // items of each bin
+    cinolib::AABB cbox[BVH_NUM_BINS];  // centroids of each bin
+    uint          count[BVH_NUM_BINS] = {};
+
+    inline void merge(const BVHBins &b)
+    {
+        for(uint i = 0; i < BVH_NUM_BINS; i++)
+        {
+            growBox(bbox[i], b.bbox[i]);
+            growBox(cbox[i], b.cbox[i]);
+            count[i] += b.count[i];
+        }
+    }
+};
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline BVHBroadphase::BVHBroadphase(uint max_leaf_size) : max_leaf_size(max_leaf_size)
+{}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline BroadphaseType BVHBroadphase::type() const
+{
+    return BROADPHASE_BVH;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BVHBroadphase::build(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris)
+{
+    initItems(verts, tris);
+    uint num_items = numItems();
+    if(num_items == 0) return;
+
+    // the build partitions a compact copy of the bounds, items are only accessed through order afterwards
+    std::vector<BVHBuildItem> prims(num_items);
+    tbb::parallel_for((uint)0, num_items, [&](uint i)
+    {
+        prims[i].bbox     = boxes[i];
+        prims[i].centroid = boxes[i].center();
+        prims[i].id       = i;
+    });
+
+    // a binary tree with non empty leaves has at most 2n-1 nodes, so nodes never grows during the build
+    nodes.resize(2 * num_items - 1);
+    std::atomic<uint> num_nodes(1);
+    cinolib::AABB cbox;
+    computeBounds(0, num_items, prims, nodes[0].bbox, cbox);
+    buildNode(0, 0, num_items, cbox, prims, num_nodes);
+    nodes.resize(num_nodes);
+
+    order.resize(num_items);
+    bounds.resize(num_items);
+    tbb::parallel_for((uint)0, num_items, [&](uint i)
+    {
+        order[i] = prims[i].id;
+        bounds.set(i, prims[i].bbox);
+    });
+
+    built_area.resize(nodes.size());
+    tbb::parallel_for((uint)0, (uint)nodes.size(), [&](uint n){ built_area[n] = halfSurfaceArea(nodes[n].bbox); });
+
+    box = nodes[0].bbox;
+    box.scale(1.5); // same as the octree root, used to place the ray endpoints
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool BVHBroadphase::refit(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris)
+{
+    std::vector<uint> moved;
+    if(nodes.empty() || !refitItems(verts, tris, moved)) return false;
+    if(moved.empty()) return true;
+
+    uint num_items = numItems();
+    tbb::parallel_for((uint)0, num_items, [&](uint i){ bounds.set(i, boxes[order[i]]); });
+
+    std::vector<uint> range_begin, range_end;
+    refitBounds(range_begin, range_end);
+
+    // topmost inner nodes that grew too much since they were built
+    std::vector<uint> rebuild;
+    std::vector<uint> lifo(1, 0);
+    while(!lifo.empty())
+    {
+        uint n = lifo.back();
+        lifo.pop_back();
+        if(nodes[n].count > 0) continue;
+        if(halfSurfaceArea(nodes[n].bbox) > BVH_REFIT_MAX_GROWTH * built_area[n]) rebuild.push_back(n);
+        else
+        {
+            lifo.push_back(nodes[n].first);
+            lifo.push_back(nodes[n].first + 1);
+        }
+    }
+    if(rebuild.empty()) return true;
+    if(rebuild[0] == 0) return false;
+
+    // the new subtrees are appended to nodes, so children still come after their parent. The old ones
+    // are left unreferenced
+    uint num_old = static_cast<uint>(nodes.size());
+    size_t max_nodes = num_old;
+    for(uint n : rebuild) max_nodes += 2 * (range_end[n] - range_begin[n]) - 1;
+    if(max_nodes > 2 * (2 * static_cast<size_t>(num_items) - 1)) return false;
+    nodes.resize(max_nodes);
+
+    std::vector<BVHBuildItem> prims(num_items);
+    std::atomic<uint> num_nodes(num_old);
+    tbb::parallel_for((uint)0, (uint)rebuild.size(), [&](uint r)
+    {
+        uint n = rebuild[r], begin = range_begin[n], end = range_end[n];
+        for(uint i = begin; i < end; i++)
+        {
+            prims[i].bbox     = boxes[order[i]];
+            prims[i].centroid = prims[i].bbox.center();
+            prims[i].id       = order[i];
+        }
+
+        cinolib::AABB bbox, cbox;
+        computeBounds(begin, end, prims, bbox, cbox);
+        buildNode(n, begin, end, cbox, prims, num_nodes);
+
+        for(uint i = begin; i < end; i++)
+        {
+            order[i] = prims[i].id;
+            bounds.set(i, prims[i].bbox);
+        }
+        built_area[n] = halfSurfaceArea(nodes[n].bbox);
+    });
+    nodes.resize(num_nodes);
+
+    built_area.resize(nodes.size());
+    tbb::parallel_for(num_old, (uint)nodes.size(), [&](uint n){ built_area[n] = halfSurfaceArea(nodes[n].bbox); });
+
+    box = nodes[0].bbox;
+    box.scale(1.5);
+    return true;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// recomputes the node bounds from the item bounds, and the range of order covered by each node
+inline void BVHBroadphase::refitBounds(std::vector<uint> &range_begin, std::vector<uint> &range_end)
+{
+    uint num_nodes = static_cast<uint>(nodes.size());
+    range_begin.resize(num_nodes);
+    range_end.resize(num_nodes);
+
+    tbb::parallel_for((uint)0, num_nodes, [&](uint n)
+    {
+        BVHNode &node = nodes[n];
+        if(node.count == 0) return;
+        node.bbox.reset();
+        for(uint i = node.first; i < node.first + node.count; i++) growBox(node.bbox, boxes[order[i]]);
+        range_begin[n] = node.first;
+        range_end[n]   = node.first + node.count;
+    });
+
+    // children always come after their parent
+    for(uint n = num_nodes; n-- > 0;)
+    {
+        BVHNode &node = nodes[n];
+        if(node.count > 0) continue;
+        node.bbox = nodes[node.first].bbox;
+        growBox(node.bbox, nodes[node.first + 1].bbox);
+        range_begin[n] = range_begin[node.first];
+        range_end[n]   = range_end[node.first + 1];
+    }
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BVHBroadphase::computeBounds(uint begin, uint end, const std::vector<BVHBuildItem> &prims,
+                                         cinolib::AABB &bbox, cinolib::AABB &cbox) const
+{
+    typedef std::pair<cinolib::AABB, cinolib::AABB> Bounds;
+    auto add_bounds = [&](const tbb::blocked_range<uint> &r, Bounds b)
+    {
+        for(uint i = r.begin(); i < r.end(); i++)
+        {
+            growBox(b.first,  prims[i].bbox);
+            growBox(b.second, prims[i].centroid);
+        }
+        return b;
+    };
+    auto merge_bounds = [](Bounds b0, const Bounds &b1)
+    {
+        growBox(b0.first,  b1.first);
+        growBox(b0.second, b1.second);
+        return b0;
+    };
+    Bounds b = (end - begin > BVH_PARALLEL_BUILD_SIZE)
+             ? tbb::parallel_reduce(tbb::blocked_range<uint>(begin, end), Bounds(), add_bounds, merge_bounds)
+             : add_bounds(tbb::blocked_range<uint>(begin, end), Bounds());
+    bbox = b.first;
+    cbox = b.second;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// the bounds of node_id are set by its parent, cbox bounds the centroids of its items
+inline void BVHBroadphase::buildNode(uint node_id, uint begin, uint end, const cinolib::AABB &cbox,
+                                     std::vector<BVHBuildItem> &prims, std::atomic<uint> &num_nodes)
+{
+    BVHNode &node = nodes[node_id];
+    uint count = end - begin;
+    bool parallel = count > BVH_PARALLEL_BUILD_SIZE;
+
+    auto make_leaf = [&]()
+    {
+        node.first = begin;
+        node.count = count;
+    };
+
+    if(count <= BVH_MIN_LEAF_SIZE) return make_leaf();
+
+    cinolib::vec3d extent = cbox.delta();
+    int axis = (extent.x() >= extent.y() && extent.x() >= extent.z()) ? 0 : (extent.y() >= extent.z() ? 1 : 2);
+    uint mid = begin;
+    cinolib::AABB child_bbox[2], child_cbox[2];
+
+    if(extent[axis] > 0.0)
+    {
+        double bin_scale = BVH_NUM_BINS / extent[axis];
+        auto bin_of = [&](const BVHBuildItem &p)
+        {
+            return std::min((int)((p.centroid[axis] - cbox.min[axis]) * bin_scale), BVH_NUM_BINS - 1);
+        };
+
+        auto add_bins = [&](const tbb::blocked_range<uint> &r, BVHBins bins)
+        {
+            for(uint i = r.begin(); i < r.end(); i++)
+            {
+                int b = bin_of(prims[i]);
+                growBox(bins.bbox[b], prims[i].bbox);
+                growBox(bins.cbox[b], prims[i].centroid);
+                bins.count[b]++;
+            }
+            return bins;
+        };
+        auto merge_bins = [](BVHBins b0, const BVHBins &b1)
+        {
+            b0.merge(b1);
+            return b0;
+        };
+        BVHBins bins = parallel ? tbb::parallel_reduce(tbb::blocked_range<uint>(begin, end), BVHBins(), add_bins, merge_bins)
+                                : add_bins(tbb::blocked_range<uint>(begin, end), BVHBins());
+
+        // SAH cost of splitting before bin i: one traversal plus the expected number of tested items
+        double right_area[BVH_NUM_BINS];
+        uint   right_count[BVH_NUM_BINS];
+        cinolib::AABB acc;
+        uint num = 0;
+        for(int i = BVH_NUM_BINS - 1; i > 0; i--)
+        {
+            growBox(acc, bins.bbox[i]);
+            num += bins.count[i];
+            right_area[i] = halfSurfaceArea(acc);
+            right_count[i] = num;
+        }
+
+        double node_area = halfSurfaceArea(node.bbox);
+        double best_cost = std::numeric_limits<double>::max();
+        int best_bin = -1;
+        acc.reset();
+        num = 0;
+        for(int i = 1; i < BVH_NUM_BINS; i++)
+        {
+            growBox(acc, bins.bbox[i - 1]);
+            num += bins.count[i - 1];
+            if(num == 0 || right_count[i] == 0) continue;
+
+            double cost = node_area + halfSurfaceArea(acc) * num + right_area[i] * right_count[i];
+            if(cost < best_cost)
+            {
+                best_cost = cost;
+                best_bin = i;
+            }
+        }
+
+        if(count <= max_leaf_size && node_area * count <= best_cost) return make_leaf();
+
+        if(best_bin > 0)
+        {
+            mid = static_cast<uint>(std::partition(prims.begin() + begin, prims.begin() + end,
+                                                   [&](const BVHBuildItem &p){ return bin_of(p) < best_bin; }) - prims.begin());
+            for(int i = 0; i < BVH_NUM_BINS; i++)
+            {
+                growBox(child_bbox[i >= best_bin], bins.bbox[i]);
+                growBox(child_cbox[i >= best_bin], bins.cbox[i]);
+            }
+        }
+    }
+    else if(count <= max_leaf_size) return make_leaf();
+
+    if(mid == begin || mid == end) // coincident centroids, split in the middle
+    {
+        mid = begin + count / 2;
+        std::nth_element(prims.begin() + begin, prims.begin() + mid, prims.begin() + end,
+                         [&](const BVHBuildItem &a, const BVHBuildItem &b){ return a.centroid[axis] < b.centroid[axis]; });
+        computeBounds(begin, mid, prims, child_bbox[0], child_cbox[0]);
+        computeBounds(mid,   end, prims, child_bbox[1], child_cbox[1]);
+    }
+
+    uint left = num_nodes.fetch_add(2);
+    node.first = left;
+    node.count = 0;
+    nodes[left    ].bbox = child_bbox[0];
+    nodes[left + 1].bbox = child_bbox[1];
+
+    if(parallel)
+        tbb::parallel_invoke([&]{ buildNode(left,     begin, mid, child_cbox[0], prims, num_nodes); },
+                             [&]{ buildNode(left + 1, mid,   end, child_cbox[1], prims, num_nodes); });
+    else
+    {
+        buildNode(left,     begin, mid, child_cbox[0], prims, num_nodes);
+        buildNode(left + 1, mid,   end, child_cbox[1], prims, num_nodes);
+    }
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BVHBroadphase::visitOverlappingPairs(PairVisitor &visitor, const std::atomic<bool> *cancel) const
+{
+    if(!nodes.empty()) selfPairs(0, 0, visitor, cancel);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void BVHBroadphase::visitOverlappingPairs(const BVHBroadphase &other, PairVisitor &visitor, const std::atomic<bool> *cancel) const
+{
+    if(!nodes.empty() && !other.nodes.empty()) crossPairs(0, other, 0, 0, visitor, cancel);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// pairs of items both contained in the subtree of node_id
+inline void BVHBroadphase::selfPairs(uint node_id, uint depth, PairVisitor &visitor, const std::atomic<bool> *cancel) const
+{
+    if(isCancelled(cancel)) return;
+
+    const BVHNode &node = nodes[node_id];
+    if(node.count > 0)
+    {
+        uint end = node.first + node.count;
+        for(uint i = node.first; i < end; i++)
+            bounds.forEachOverlap(boxes[order[i]], i + 1, end, [&](uint j){ visitor.visit(order[i], order[j]); });
+        return;
+    }
+
+    uint left = node.first, right = node.first + 1;
+    if(depth < BVH_PARALLEL_DEPTH)
+        tbb::parallel_invoke([&]{ selfPairs(left,  depth + 1, visitor, cancel); },
+                             [&]{ selfPairs(right, depth + 1, visitor, cancel); },
+                             [&]{ crossPairs(left, *this, right, depth + 1, visitor, cancel); });
+    else
+    {
+        selfPairs(left,  depth + 1, visitor, cancel);
+        selfPairs(right, depth + 1, visitor, cancel);
+        crossPairs(left, *this, right, depth + 1, visitor, cancel);
+    }
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// pairs made of an item in the subtree of n0_id and an item in the subtree of n1_id of t1 (possibly this tree)
+inline void BVHBroadphase::crossPairs(uint n0_id, const BVHBroadphase &t1, uint n1_id, uint depth, PairVisitor &visitor,
+                                      const std::atomic<bool> *cancel) const
+{
+    const BVHNode &n0 = nodes[n0_id];
+    const BVHNode &n1 = t1.nodes[n1_id];
+    if(!n0.bbox.intersects_box(n1.bbox)) return;
+
+    if(n0.count > 0 && n1.count > 0)
+    {
+        for(uint i = n0.first; i < n0.first + n0.count; i++)
+            t1.bounds.forEachOverlap(boxes[order[i]], n1.first, n1.first + n1.count,
+                                     [&](uint j){ visitor.visit(order[i], t1.order[j]); });
+        return;
+    }
+
+    if(depth < BVH_PARALLEL_DEPTH && isCancelled(cancel)) return;
+
+    // descend the inner node with the larger box
+    bool split_n0 = n1.count > 0 || (n0.count == 0 && halfSurfaceArea(n0.bbox) >= halfSurfaceArea(n1.bbox));
+    uint a0 = split_n0 ? n0.first     : n0_id;
+    uint a1 = split_n0 ? n0.first + 1 : n0_id;
+    uint b0 = split_n0 ? n1_id        : n1.first;
+    uint b1 = split_n0 ? n1_id        : n1.first + 1;
+
+    if(depth < BVH_PARALLEL_DEPTH)
+        tbb::parallel_invoke([&]{ crossPairs(a0, t1, b0, depth + 1, visitor, cancel); },
+                             [&]{ crossPairs(a1, t1, b1, depth + 1, visitor, cancel); });
+    else
+    {
+        crossPairs(a0, t1, b0, depth + 1, visitor, cancel);
+        crossPairs(a1, t1, b1, depth + 1, visitor, cancel);
+    }
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool BVHBroadphase::intersectsBox(const cinolib::AABB &b, phmap::flat_hash_set<uint> &ids) const
+{
+    if(nodes.empty()) return false;
+
+    std::vector<uint> lifo;
+    lifo.reserve(64);
+    if(nodes[0].bbox.intersects_box(b)) lifo.push_back(0);
+
+    while(!lifo.empty())
+    {
+        const BVHNode &node = nodes[lifo.back()];
+        lifo.pop_back();
+
+        if(node.count > 0)
+        {
+            bounds.forEachOverlap(b, node.first, node.first + node.count, [&](uint i){ ids.insert(order[i]); });
+        }
+        else
+        {
+            if(nodes[node.first    ].bbox.intersects_box(b)) lifo.push_back(node.first);
+            if(nodes[node.first + 1].bbox.intersects_box(b)) lifo.push_back(node.first + 1);
+        }
+    }
+
+    return !ids.empty();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint BVHBroadphase::numNodes() const
+{
+    return static_cast<uint>(nodes.size());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline size_t BVHBroadphase::memoryUsage() const
+{
+    return itemsMemoryUsage() + nodes.capacity() * sizeof(BVHNode) + built_area.capacity() * sizeof(double) +
+           order.capacity() * sizeof(uint) + bounds.memoryUsage();
+}
@@ -0,0 +1,115 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_BVH_H
+#define EXACT_BOOLEANS_BVH_H
+
+#include "broadphase.h"
+#include "aabb_array.h"
+
+struct BVHNode
+{
+    cinolib::AABB bbox;
+    uint first = 0; // leaf: first slot of its items in BVHBroadphase::order. Inner node: left child (the right one is first + 1)
+    uint count = 0; // number of items of a leaf, 0 for inner nodes
+};
+
+// bounds of an item, partitioned in place while building the tree
+struct BVHBuildItem
+{
+    cinolib::AABB  bbox;
+    cinolib::vec3d centroid;
+    uint           id;
+};
+
+/* Broadphase backend based on a binary BVH over the triangle AABBs. Splits are chosen with the binned
+ * surface area heuristic and subtrees are built in parallel. Each item is stored in a single leaf, and
+ * overlapping pairs are found by traversing the tree against itself
+*/
+
+class BVHBroadphase : public Broadphase
+{
+    public:
+
+        inline explicit BVHBroadphase(uint max_leaf_size = 8);
+
+        inline BroadphaseType type() const override;
+
+        inline void build(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris) override;
+
+        // the bounds of the tree of the last build are updated bottom-up, and the topmost subtrees whose
+        // surface area more than doubled since they were built are built again. Falls back to build if
+        // that happens at the root, or if the discarded nodes make the tree twice as large as needed
+        inline bool refit(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris) override;
+
+        inline void visitOverlappingPairs(PairVisitor &visitor, const std::atomic<bool> *cancel = nullptr) const override;
+
+        // pairs made of an item of this tree and an item of other with overlapping AABBs, visited as
+        // (id in this tree, id in other)
+        inline void visitOverlappingPairs(const BVHBroadphase &other, PairVisitor &visitor, const std::atomic<bool> *cancel = nullptr) const;
+
+        inline bool intersectsBox(const cinolib::AABB &b, phmap::flat_hash_set<uint> &ids) const override;
+
+        inline uint numNodes() const override;
+
+        inline size_t memoryUsage() const override;
+
+    private:
+
+        inline void computeBounds(uint begin, uint end, const std::vector<BVHBuildItem> &prims,
+                                  cinolib::AABB &bbox, cinolib::AABB &cbox) const;
+
+        inline void buildNode(uint node_id, uint begin, uint end, const cinolib::AABB &cbox,
+                              std::vector<BVHBuildItem> &prims, std::atomic<uint> &num_nodes);
+
+        inline void refitBounds(std::vector<uint> &range_begin, std::vector<uint> &range_end);
+
+        inline void selfPairs(uint node_id, uint depth, PairVisitor &visitor, const std::atomic<bool> *cancel) const;
+
+        inline void crossPairs(uint n0_id, const BVHBroadphase &t1, uint n1_id, uint depth, PairVisitor &visitor,
+                               const std::atomic<bool> *cancel) const;
+
+        std::vector<BVHNode> nodes;
+        std::vector<double>  built_area; // surface area of each node when it was built
+        std::vector<uint>    order;  // ids of the indexed items, grouped by leaf
+        AABBArray            bounds; // bounds of the indexed items, in the same order
+        uint                 max_leaf_size;
+};
+
+#include "bvh.cpp"
+
+#endif // EXACT_BOOLEANS_BVH_H
@@ -0,0 +1,145 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "csg_expression.h"
+
+#include <cassert>
+
+inline bool CSGExpression::isValid() const
+{
+    return !nodes.empty();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint CSGExpression::numNodes() const
+{
+    return static_cast<uint>(nodes.size());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline const CSGNode &CSGExpression::node(uint n_id) const
+{
+    assert(n_id < nodes.size() && "node id out of range");
+    return nodes[n_id];
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool CSGExpression::contains(const LabelSet &inside_labels) const
+{
+    assert(isValid() && "empty CSG expression");
+
+    absl::InlinedVector<bool, 32> stack;
+
+    for(const CSGNode &n : nodes)
+    {
+        if(n.op == CSG_LEAF)
+        {
+            stack.push_back(inside_labels[n.label]);
+            continue;
+        }
+
+        assert(stack.size() >= 2 && "badly formed CSG expression");
+        bool b1 = stack.back(); stack.pop_back();
+        bool b0 = stack.back(); stack.pop_back();
+
+        switch(n.op)
+        {
+            case CSG_UNION:        stack.push_back(b0 || b1); break;
+            case CSG_INTERSECTION: stack.push_back(b0 && b1); break;
+            case CSG_SUBTRACTION:  stack.push_back(b0 && !b1); break;
+            case CSG_XOR:          stack.push_back(b0 != b1); break;
+            default: assert(false && "unknown CSG operation");
+        }
+    }
+
+    assert(stack.size() == 1 && "badly formed CSG expression");
+    return stack.back();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline CSGExpression csgLeaf(uint label)
+{
+    CSGExpression e;
+    e.nodes.push_back({CSG_LEAF, label});
+    return e;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline CSGExpression csgCombine(const CSGExpression &e0, const CSGExpression &e1, CSGOp op)
+{
+    assert(op != CSG_LEAF && e0.isValid() && e1.isValid());
+
+    CSGExpression e;
+    e.nodes.reserve(e0.nodes.size() + e1.nodes.size() + 1);
+    e.nodes.insert(e.nodes.end(), e0.nodes.begin(), e0.nodes.end());
+    e.nodes.insert(e.nodes.end(), e1.nodes.begin(), e1.nodes.end());
+    e.nodes.push_back({op, 0});
+    return e;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline CSGExpression csgUnion(const CSGExpression &e0, const CSGExpression &e1)
+{
+    return csgCombine(e0, e1, CSG_UNION);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline CSGExpression csgIntersection(const CSGExpression &e0, const CSGExpression &e1)
+{
+    return csgCombine(e0, e1, CSG_INTERSECTION);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline CSGExpression csgSubtraction(const CSGExpression &e0, const CSGExpression &e1)
+{
+    return csgCombine(e0, e1, CSG_SUBTRACTION);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline CSGExpression csgXOR(const CSGExpression &e0, const CSGExpression &e1)
+{
+    return csgCombine(e0, e1, CSG_XOR);
+}
@@ -0,0 +1,102 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_CSG_EXPRESSION_H
+#define EXACT_BOOLEANS_CSG_EXPRESSION_H
+
+#include "common.h"
+
+#include <vector>
+
+#include <absl/container/inlined_vector.h>
+
+enum CSGOp {CSG_LEAF, CSG_UNION, CSG_INTERSECTION, CSG_SUBTRACTION, CSG_XOR};
+
+struct CSGNode
+{
+    CSGOp op;
+    uint  label; // input label, used by CSG_LEAF only
+};
+
+/* A boolean expression over the input meshes. The leaves are input labels and the expression is
+ * built with the csg* functions, e.g. (A ∪ B) − (C ∩ D) becomes
+ *
+ *      csgSubtraction(csgUnion(csgLeaf(0), csgLeaf(1)), csgIntersection(csgLeaf(2), csgLeaf(3)))
+ *
+ * The tree is stored in postfix order, so that it can be evaluated for each triangle of the arrangement
+ * with a small stack. A triangle is part of the result if the expression has a different value on the
+ * two sides of the triangle, and it is flipped if the result lies on the side its normal points to.
+*/
+
+class CSGExpression
+{
+    public:
+
+        inline CSGExpression() {}
+
+        inline bool isValid() const;
+
+        inline uint numNodes() const;
+
+        inline const CSGNode &node(uint n_id) const;
+
+        // true if a point inside the meshes in inside_labels (and outside all the others) is in the result
+        inline bool contains(const LabelSet &inside_labels) const;
+
+        friend inline CSGExpression csgLeaf(uint label);
+        friend inline CSGExpression csgCombine(const CSGExpression &e0, const CSGExpression &e1, CSGOp op);
+
+    private:
+
+        std::vector<CSGNode> nodes; // postfix order
+};
+
+inline CSGExpression csgLeaf(uint label);
+
+inline CSGExpression csgCombine(const CSGExpression &e0, const CSGExpression &e1, CSGOp op);
+
+inline CSGExpression csgUnion(const CSGExpression &e0, const CSGExpression &e1);
+
+inline CSGExpression csgIntersection(const CSGExpression &e0, const CSGExpression &e1);
+
+inline CSGExpression csgSubtraction(const CSGExpression &e0, const CSGExpression &e1);
+
+inline CSGExpression csgXOR(const CSGExpression &e0, const CSGExpression &e1);
+
+#include "csg_expression.cpp"
+
+#endif // EXACT_BOOLEANS_CSG_EXPRESSION_H
@@ -0,0 +1,220 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "dual_tree_broadphase.h"
+
+#include <tbb/tbb.h>
+
+inline BroadphaseType DualTreeBroadphase::type() const
+{
+    return BROADPHASE_DUAL;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void DualTreeBroadphase::setGroups(std::vector<uint> groups, bool skip)
+{
+    next_groups.swap(groups);
+    skip_same_group = skip;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void DualTreeBroadphase::build(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris)
+{
+    initItems(verts, tris);
+    uint num_items = numItems();
+
+    if(next_groups.size() == num_items) item_group = next_groups;
+    else                                item_group.assign(num_items, 0);
+
+    // group ids are compacted to the trees of the non empty groups
+    uint num_groups = num_items > 0 ? *std::max_element(item_group.begin(), item_group.end()) + 1 : 0;
+    std::vector<uint> group_size(num_groups, 0);
+    for(uint g : item_group) group_size[g]++;
+
+    std::vector<uint> tree_of_group(num_groups, 0);
+    group_items.clear();
+    for(uint g = 0; g < num_groups; g++)
+    {
+        if(group_size[g] == 0) continue;
+        tree_of_group[g] = static_cast<uint>(group_items.size());
+        group_items.emplace_back();
+        group_items.back().reserve(group_size[g]);
+    }
+    for(uint i = 0; i < num_items; i++) group_items[tree_of_group[item_group[i]]].push_back(i);
+
+    trees.clear();
+    trees.resize(group_items.size());
+    updateTrees(std::vector<uint8_t>(trees.size(), 1));
+
+    box = cinolib::AABB();
+    for(const cinolib::AABB &b : boxes) box.push(b);
+    box.scale(1.5);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool DualTreeBroadphase::refit(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris)
+{
+    std::vector<uint> moved;
+    if(trees.empty() || !refitItems(verts, tris, moved)) return false;
+
+    uint num_items = numItems();
+    if(next_groups.size() == num_items ? next_groups != item_group
+                                       : std::any_of(item_group.begin(), item_group.end(), [](uint g){ return g != 0; }))
+        return false;
+    if(moved.empty()) return true;
+
+    // only the trees of the groups with moved items are touched
+    phmap::flat_hash_map<uint, uint> tree_of_group;
+    for(uint t = 0; t < trees.size(); t++) tree_of_group[item_group[group_items[t][0]]] = t;
+    std::vector<uint8_t> needs_update(trees.size(), 0);
+    for(uint i : moved) needs_update[tree_of_group[item_group[i]]] = 1;
+    updateTrees(needs_update);
+
+    box = cinolib::AABB();
+    for(const cinolib::AABB &b : boxes) box.push(b);
+    box.scale(1.5);
+    return true;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void DualTreeBroadphase::updateTrees(const std::vector<uint8_t> &needs_update)
+{
+    tbb::parallel_for((uint)0, (uint)trees.size(), [&](uint t)
+    {
+        if(!needs_update[t]) return;
+
+        // the tree of a group only gets the vertices of its items
+        const std::vector<uint> &items = group_items[t];
+        phmap::flat_hash_map<uint, uint> vert_map;
+        std::vector<cinolib::vec3d> group_verts;
+        std::vector<uint> group_tris(3 * items.size());
+        for(uint i = 0; i < items.size(); i++)
+        {
+            for(uint k = 0; k < 3; k++)
+            {
+                uint v_id = tris[3 * items[i] + k];
+                auto ins = vert_map.emplace(v_id, static_cast<uint>(group_verts.size()));
+                if(ins.second) group_verts.push_back(verts[v_id]);
+                group_tris[3 * i + k] = ins.first->second;
+            }
+        }
+
+        if(!trees[t]) trees[t] = std::make_unique<BVHBroadphase>();
+        if(!trees[t]->refit(group_verts, group_tris)) trees[t]->build(group_verts, group_tris);
+    });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void DualTreeBroadphase::visitOverlappingPairs(PairVisitor &visitor, const std::atomic<bool> *cancel) const
+{
+    // maps the ids of the items in two trees back to the ids of this broadphase
+    class GroupPairVisitor : public PairVisitor
+    {
+        public:
+
+            GroupPairVisitor(PairVisitor &visitor, const std::vector<uint> &items0, const std::vector<uint> &items1)
+                : visitor(visitor), items0(items0), items1(items1) {}
+
+            void visit(uint id0, uint id1) override
+            {
+                visitor.visit(items0[id0], items1[id1]);
+            }
+
+            PairVisitor             &visitor;
+            const std::vector<uint> &items0;
+            const std::vector<uint> &items1;
+    };
+
+    std::vector<std::pair<uint, uint>> tree_pairs;
+    for(uint t0 = 0; t0 < trees.size(); t0++)
+    {
+        if(!skip_same_group) tree_pairs.emplace_back(t0, t0);
+        for(uint t1 = t0 + 1; t1 < trees.size(); t1++)
+            if(trees[t0]->bbox().intersects_box(trees[t1]->bbox())) tree_pairs.emplace_back(t0, t1);
+    }
+
+    tbb::parallel_for((uint)0, (uint)tree_pairs.size(), [&](uint p)
+    {
+        uint t0 = tree_pairs[p].first, t1 = tree_pairs[p].second;
+        GroupPairVisitor group_visitor(visitor, group_items[t0], group_items[t1]);
+        if(t0 == t1) trees[t0]->visitOverlappingPairs(group_visitor, cancel);
+        else         trees[t0]->visitOverlappingPairs(*trees[t1], group_visitor, cancel);
+    });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool DualTreeBroadphase::intersectsBox(const cinolib::AABB &b, phmap::flat_hash_set<uint> &ids) const
+{
+    for(uint t = 0; t < trees.size(); t++)
+    {
+        phmap::flat_hash_set<uint> tree_ids;
+        if(trees[t]->intersectsBox(b, tree_ids))
+            for(uint id : tree_ids) ids.insert(group_items[t][id]);
+    }
+    return !ids.empty();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint DualTreeBroadphase::numNodes() const
+{
+    uint num_nodes = 0;
+    for(const std::unique_ptr<BVHBroadphase> &t : trees) num_nodes += t->numNodes();
+    return num_nodes;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline size_t DualTreeBroadphase::memoryUsage() const
+{
+    size_t bytes = itemsMemoryUsage() + (next_groups.capacity() + item_group.capacity()) * sizeof(uint);
+    for(uint t = 0; t < trees.size(); t++) bytes += trees[t]->memoryUsage() + group_items[t].capacity() * sizeof(uint);
+    return bytes;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint DualTreeBroadphase::numGroups() const
+{
+    return static_cast<uint>(trees.size());
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_DUAL_TREE_BROADPHASE_H
+#define EXACT_BOOLEANS_DUAL_TREE_BROADPHASE_H
+
+#include "bvh.h"
+
+#include <memory>
+
+/* Broadphase backend with one BVH for each group of items (e.g. each input mesh). Pairs of items in
+ * different groups are found by traversing the two trees against each other, which only descends into
+ * overlapping node pairs, so that meshes far from each other cost about as much as their contact region.
+ * With skip_same_group (see setGroups) the pairs inside a group are not reported at all, which is the
+ * only difference from the results of the other backends.
+ * The trees are refitted independently: the tree of a group whose items did not move is kept as is
+*/
+
+class DualTreeBroadphase : public Broadphase
+{
+    public:
+
+        inline DualTreeBroadphase() {}
+
+        inline BroadphaseType type() const override;
+
+        // group of each item of the next build or refit. All the items go in a single group if groups
+        // does not have one entry for each item
+        inline void setGroups(std::vector<uint> groups, bool skip_same_group);
+
+        inline void build(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris) override;
+
+        // keeps the trees of the last build if the groups did not change, refitting the ones with moved items
+        inline bool refit(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris) override;
+
+        inline void visitOverlappingPairs(PairVisitor &visitor, const std::atomic<bool> *cancel = nullptr) const override;
+
+        inline bool intersectsBox(const cinolib::AABB &b, phmap::flat_hash_set<uint> &ids) const override;
+
+        inline uint numNodes() const override;
+
+        inline size_t memoryUsage() const override;
+
+        inline uint numGroups() const; // non empty ones
+
+    private:
+
+        // builds (or refits, if possible) the tree of each group in needs_update
+        inline void updateTrees(const std::vector<uint8_t> &needs_update);
+
+        std::vector<uint>                           next_groups; // set by setGroups
+        std::vector<uint>                           item_group;  // group of each indexed item
+        std::vector<std::vector<uint>>              group_items; // item ids of each non empty group, by id in its tree
+        std::vector<std::unique_ptr<BVHBroadphase>> trees;       // one for each non empty group
+        bool skip_same_group = false;
+};
+
+#include "dual_tree_broadphase.cpp"
+
+#endif // EXACT_BOOLEANS_DUAL_TREE_BROADPHASE_H
@@ -40,6 +40,8 @@
 #include <cinolib/geometry/triangle.h>
 #include <stack>
 
+#include "radix_sort.h"
+
 #include <tbb/tbb.h>
 
 namespace cinolib
@@ -68,154 +70,502 @@ std::vector<int> FOctree::get_leaves() const {
     auto leaves = std::vector<int>();
     leaves.reserve(nodes.size());
     for(auto node_id = 0; node_id < (int)nodes.size(); node_id++)
-        if(!nodes[node_id].is_inner) leaves.push_back(node_id);
+        if(!nodes[node_id].is_inner()) leaves.push_back(node_id);
     return leaves;
 }
 
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 CINO_INLINE
-void FOctree::build_recursive(uint max_depth, uint items_per_leaf, int node_id, int depth, tbb::spin_mutex& mutex, tbb::task_group& group)
+size_t FOctree::memory_usage() const
+{
+    return nodes.capacity() * sizeof(FOctreeNode) + leaf_items.capacity() * sizeof(uint);
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+CINO_INLINE
+void FOctree::build_recursive(uint max_depth, uint items_per_leaf, uint node_id, uint depth, tbb::task_group& group)
 {
-    subdivide(node_id, mutex);
+    subdivide(node_id);
 
-    auto node = &nodes[node_id]; 
-    for(int j=0; j<8; ++j)
+    uint start = build_nodes[node_id].start;
+    for(uint j=0; j<8; ++j)
     {
-        auto child_id = node->start + j;
-        auto child = &nodes[node->start + j];
-        if(depth<max_depth && child->item_indices.size()>items_per_leaf)
+        uint child_id = start + j;
+        if(depth<max_depth && build_nodes[child_id].item_indices.size()>items_per_leaf)
         {
-            group.run([=,&mutex,&group]{ this->build_recursive(max_depth, items_per_leaf, child_id, depth+1, mutex, group); });
+            group.run([=,&group]{ this->build_recursive(max_depth, items_per_leaf, child_id, depth+1, group); });
         }
     }
 }
 
 CINO_INLINE
-void FOctree::build(uint max_depth, uint items_per_leaf, bool parallel)
+void FOctree::build(const std::vector<AABB> & boxes, uint max_depth, uint items_per_leaf, bool parallel)
 {
     this->max_depth = max_depth;
     this->items_per_leaf = items_per_leaf;
 
-    if(items.empty()) return;
-
-    // HACK
-    nodes.reserve(items.size());
+    nodes.clear();
+    leaf_items.clear();
+    build_nodes.clear();
+    if(boxes.empty()) return;
+    this->boxes = &boxes;
 
     // initialize root with all items, also updating its AABB
-    auto root = &nodes.emplace_back(AABB());
-    root->item_indices.resize(items.size());
-    std::iota(root->item_indices.begin(),root->item_indices.end(),0);
-    for(auto& it : items) root->bbox.push(it.aabb);
-
-    root->bbox.scale(1.5); // enlarge bbox to account for queries outside legal area.
-                           // this should disappear eventually....
-
-    if(parallel) {
-        if(root->item_indices.size()<items_per_leaf || max_depth==1) return;
-        if(max_depth == 2) {
-            tbb::spin_mutex mutex;
-            subdivide(0, mutex);
-        } else {
-            tbb::spin_mutex mutex;
-            tbb::task_group group;
-            build_recursive(max_depth, items_per_leaf, 0, 1, mutex, group);
-            group.wait();
+    FOctreeBuildNode & root = *build_nodes.emplace_back(AABB());
+    root.item_indices.resize(boxes.size());
+    std::iota(root.item_indices.begin(),root.item_indices.end(),0);
+    root.bbox = root_bbox(boxes); // enlarged to account for queries outside legal area.
+                                  // this should disappear eventually....
+
+    if(root.item_indices.size()<items_per_leaf || max_depth==1)
+    {
+    }
+    else if(max_depth==2)
+    {
+        subdivide(0);
+    }
+    else if(parallel)
+    {
+        tbb::task_group group;
+        build_recursive(max_depth, items_per_leaf, 0, 1, group);
+        group.wait();
+    }
+    else
+    {
+        subdivide(0);
+
+        std::queue<std::pair<uint,uint>> splitlist[8]; // (node, depth)
+        for(uint i=0; i<8; ++i)
+        {
+            uint child_id = root.start + i;
+            if(build_nodes[child_id].item_indices.size()>items_per_leaf)
+            {
+                splitlist[i].push(std::make_pair(child_id,2));
+            }
         }
-    } else {
-        tbb::spin_mutex mutex;
-        if(root->item_indices.size()<items_per_leaf || max_depth==1)
+
+        tbb::parallel_for((uint)0, (uint)8, [&](uint i)
         {
+            while(!splitlist[i].empty())
+            {
+                uint node_id = splitlist[i].front().first;
+                uint depth   = splitlist[i].front().second + 1;
+                splitlist[i].pop();
+
+                subdivide(node_id);
+
+                uint start = build_nodes[node_id].start;
+                for(uint j=0; j<8; ++j)
+                {
+                    uint child_id = start + j;
+                    if(depth<max_depth && build_nodes[child_id].item_indices.size()>items_per_leaf)
+                    {
+                        splitlist[i].push(std::make_pair(child_id, depth));
+                    }
+                }
+            }
+        });
+    }
+
+    compact();
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// spreads the lowest 21 bits of v, leaving two zeros between consecutive bits
+CINO_INLINE
+uint64_t morton_expand_bits(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffff;
+    v = (v | v << 16) & 0x1f0000ff0000ff;
+    v = (v | v << 8)  & 0x100f00f00f00f00f;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3;
+    v = (v | v << 2)  & 0x1249249249249249;
+    return v;
+}
+
+CINO_INLINE
+void FOctree::build_morton_recursive(uint max_depth, uint items_per_leaf, uint node_id, uint depth, uint begin, uint end,
+                                     const std::vector<uint64_t> & codes, tbb::concurrent_vector<FOctreeMortonLeaf> & leaves,
+                                     tbb::task_group & group)
+{
+    FOctreeBuildNode & node = build_nodes[node_id];
+    vec3d min = node.bbox.min;
+    vec3d max = node.bbox.max;
+    vec3d avg = node.bbox.center();
+    auto it = build_nodes.grow_by(8);
+    node.start = (int)(it - build_nodes.begin());
+    node.is_inner = true;
+
+    // child i has the codes whose 3 bits at shift are i (bit 0 for x, 1 for y and 2 for z). The codes
+    // in [begin, end) share all the bits above, so they are sorted by these 3 bits as well
+    uint shift = 3 * (21 - depth);
+    uint child_begin = begin;
+    for(uint i=0; i<8; ++i)
+    {
+        uint child_id  = node.start + i;
+        uint child_end = (uint)(std::partition_point(codes.begin() + child_begin, codes.begin() + end,
+                                                     [&](uint64_t c){ return ((c >> shift) & 7) <= i; }) - codes.begin());
+        it[i].bbox = AABB(vec3d((i & 1) ? avg[0] : min[0], (i & 2) ? avg[1] : min[1], (i & 4) ? avg[2] : min[2]),
+                          vec3d((i & 1) ? max[0] : avg[0], (i & 2) ? max[1] : avg[1], (i & 4) ? max[2] : avg[2]));
+
+        if(depth<max_depth && depth+1<=21 && child_end-child_begin>items_per_leaf) // same depth limit of build_recursive
+        {
+            group.run([=,&codes,&leaves,&group]{ this->build_morton_recursive(max_depth, items_per_leaf, child_id, depth+1, child_begin, child_end, codes, leaves, group); });
         }
         else
         {
-            subdivide(0, mutex);
+            leaves.push_back({child_id, child_begin, child_end});
+        }
+        child_begin = child_end;
+    }
+}
+
+CINO_INLINE
+void FOctree::build_morton(const std::vector<AABB> & boxes, uint max_depth, uint items_per_leaf)
+{
+    this->max_depth = max_depth;
+    this->items_per_leaf = items_per_leaf;
+
+    nodes.clear();
+    leaf_items.clear();
+    build_nodes.clear();
+    if(boxes.empty()) return;
+    this->boxes = &boxes;
+
+    // same root of build
+    FOctreeBuildNode & root = *build_nodes.emplace_back(AABB());
+    root.bbox = root_bbox(boxes);
+
+    // quantize the item centers on a 2^21 grid spanning the root
+    uint num_items = (uint)boxes.size();
+    const double cells = (double)(1 << 21);
+    vec3d origin = root.bbox.min;
+    vec3d delta  = root.bbox.delta();
+    vec3d scale(delta[0] > 0 ? cells / delta[0] : 0,
+                delta[1] > 0 ? cells / delta[1] : 0,
+                delta[2] > 0 ? cells / delta[2] : 0);
+
+    std::vector<uint64_t> codes(num_items);
+    std::vector<uint>     order(num_items);
+    tbb::parallel_for((uint)0, num_items, [&](uint i)
+    {
+        vec3d c = boxes[i].center();
+        uint64_t code = 0;
+        for(int k=0; k<3; ++k)
+        {
+            double q = std::min(std::max((c[k] - origin[k]) * scale[k], 0.0), cells - 1);
+            code |= morton_expand_bits((uint64_t)q) << k;
+        }
+        codes[i] = code;
+        order[i] = i;
+    });
+    parallelRadixSort(codes, order, 63);
+
+    tbb::concurrent_vector<FOctreeMortonLeaf> leaves;
+    if(num_items>items_per_leaf && max_depth>1)
+    {
+        tbb::task_group group;
+        build_morton_recursive(max_depth, items_per_leaf, 0, 1, 0, num_items, codes, leaves, group);
+        group.wait();
+    }
+    else
+    {
+        leaves.push_back({0, 0, num_items});
+    }
+
+    // an item strictly inside the cell of its center touches no other leaf. Sides lying on the
+    // boundary of the root don't count, as there are no leaves beyond them
+    const AABB & root_box = build_nodes[0].bbox;
+    auto inside_cell = [&](const AABB & cell, const AABB & b)
+    {
+        for(int k=0; k<3; ++k)
+        {
+            if(b.min[k] <= cell.min[k] && cell.min[k] != root_box.min[k]) return false;
+            if(b.max[k] >= cell.max[k] && cell.max[k] != root_box.max[k]) return false;
+        }
+        return true;
+    };
+
+    tbb::enumerable_thread_specific<std::vector<uint>> crossing;
+    tbb::parallel_for((uint)0, (uint)leaves.size(), [&](uint l)
+    {
+        FOctreeBuildNode & leaf = build_nodes[leaves[l].node_id];
+        std::vector<uint> & local = crossing.local();
+        for(uint s = leaves[l].begin; s < leaves[l].end; ++s)
+        {
+            if(inside_cell(leaf.bbox, boxes[order[s]])) leaf.item_indices.push_back(order[s]);
+            else local.push_back(order[s]);
+        }
+    });
+
+    // large items, and the ones crossing the boundary of their cell, are pushed down from the
+    // root to all the leaves their AABB touches, as done by subdivide
+    std::vector<uint> large;
+    for(const std::vector<uint> & local : crossing) large.insert(large.end(), local.begin(), local.end());
+    insert_items(large);
+
+    compact();
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+CINO_INLINE
+bool FOctree::refit(const std::vector<AABB> & boxes, const std::vector<uint> & moved)
+{
+    if(nodes.empty()) return false;
+    for(uint it : moved) if(!nodes[0].bbox.contains(boxes[it].min) || !nodes[0].bbox.contains(boxes[it].max)) return false;
+    this->boxes = &boxes;
+
+    // back to build nodes, without the moved items
+    std::vector<uint8_t> is_moved(boxes.size(), 0);
+    for(uint it : moved) is_moved[it] = 1;
+
+    uint num_nodes = (uint)nodes.size();
+    build_nodes.clear();
+    build_nodes.grow_by(num_nodes);
+    tbb::parallel_for((uint)0, num_nodes, [&](uint i)
+    {
+        FOctreeBuildNode & b = build_nodes[i];
+        b.bbox = nodes[i].bbox;
+        b.is_inner = nodes[i].is_inner();
+        if(b.is_inner)
+        {
+            b.start = (int)nodes[i].start;
+            return;
+        }
+        for(uint s = nodes[i].start; s < nodes[i].start + nodes[i].count; ++s)
+            if(!is_moved[leaf_items[s]]) b.item_indices.push_back(leaf_items[s]);
+    });
+
+    insert_items(moved);
+
+    // depth and number of item references of each subtree. Children always come after their parent
+    std::vector<uint>   depth(num_nodes, 1);
+    std::vector<size_t> refs(num_nodes, 0);
+    for(uint i=0; i<num_nodes; ++i)
+        if(build_nodes[i].is_inner)
+            for(uint j=0; j<8; ++j) depth[build_nodes[i].start + j] = depth[i] + 1;
+    for(uint i=num_nodes; i-- > 0;)
+    {
+        if(!build_nodes[i].is_inner) refs[i] = build_nodes[i].item_indices.size();
+        else for(uint j=0; j<8; ++j) refs[i] += refs[build_nodes[i].start + j];
+    }
+
+    // top-down: the topmost subtrees left with at most items_per_leaf/2 references (e.g. where the moved
+    // items came from) are merged into a single leaf, and the leaves reached otherwise are split as in build
+    // if they got more than twice the items they were built with (at least 2*items_per_leaf). The margins
+    // keep a subtree from being merged and split again by the following refits
+    std::vector<uint> merged, crowded;
+    std::vector<uint> lifo = {0};
+    while(!lifo.empty())
+    {
+        uint i = lifo.back();
+        lifo.pop_back();
+        if(build_nodes[i].is_inner)
+        {
+            if(2 * refs[i] <= items_per_leaf) merged.push_back(i);
+            else for(uint j=0; j<8; ++j) lifo.push_back(build_nodes[i].start + j);
+        }
+        else if(depth[i] <= max_depth && refs[i] > 2 * std::max<size_t>(items_per_leaf, nodes[i].count))
+        {
+            crowded.push_back(i);
+        }
+    }
 
-            if(max_depth==2)
+    tbb::parallel_for((uint)0, (uint)merged.size(), [&](uint m)
+    {
+        FOctreeBuildNode & node = build_nodes[merged[m]];
+        onvector<uint> items;
+        std::vector<uint> subtree;
+        for(uint j=0; j<8; ++j) subtree.push_back(node.start + j);
+        while(!subtree.empty())
+        {
+            const FOctreeBuildNode & n = build_nodes[subtree.back()];
+            subtree.pop_back();
+            if(n.is_inner) for(uint j=0; j<8; ++j) subtree.push_back(n.start + j);
+            else items.insert(items.end(), n.item_indices.begin(), n.item_indices.end());
+        }
+        std::sort(items.begin(), items.end());
+        items.erase(std::unique(items.begin(), items.end()), items.end());
+        node.item_indices = std::move(items);
+        node.is_inner = false; // the old subtree is not reachable anymore, compact drops it
+    });
+
+    tbb::task_group group;
+    for(uint i : crowded) group.run([=,&group]{ this->build_recursive(max_depth, items_per_leaf, i, depth[i], group); });
+    group.wait();
+
+    compact();
+    return true;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+CINO_INLINE
+void FOctree::insert_items(const std::vector<uint> & items)
+{
+    tbb::enumerable_thread_specific<std::vector<std::pair<uint,uint>>> hits; // (leaf, item)
+    tbb::parallel_for((uint)0, (uint)items.size(), [&](uint i)
+    {
+        const AABB & b = (*boxes)[items[i]];
+        std::vector<std::pair<uint,uint>> & local = hits.local();
+        std::stack<uint> lifo;
+        lifo.push(0);
+        while(!lifo.empty())
+        {
+            uint node_id = lifo.top();
+            lifo.pop();
+            const FOctreeBuildNode & node = build_nodes[node_id];
+            if(!node.bbox.intersects_box(b)) continue;
+            if(node.is_inner)
             {
+                for(int j=0; j<8; ++j) lifo.push(node.start + j);
             }
             else
             {
-                std::queue<std::pair<int,uint>> splitlist[8]; // (node, depth)
-                for(int i=0; i<8; ++i)
-                {
-                    auto child_id = root->start + i;
-                    auto child = &nodes[root->start + i];
-                    if(child->item_indices.size()>items_per_leaf)
-                    {
-                        splitlist[i].push(std::make_pair(child_id,2));
-                    }
-                }
-
-                tbb::parallel_for((uint)0, (uint)8, [&](uint i)
-                {
-                    while(!splitlist[i].empty())
-                    {
-                        auto pair  = splitlist[i].front();
-                        auto node_id  = pair.first;
-                        auto node  = &nodes[pair.first];
-                        uint depth = pair.second + 1;
-                        splitlist[i].pop();
-
-                        subdivide(node_id, mutex);
-
-                        for(int j=0; j<8; ++j)
-                        {
-                            auto child_id = node->start + j;
-                            auto child = &nodes[node->start + j];
-                            if(depth<max_depth && child->item_indices.size()>items_per_leaf)
-                            {
-                                splitlist[i].push(std::make_pair(child_id, depth));
-                            }
-                        }
-                    }
-                });
+                local.push_back(std::make_pair(node_id, items[i]));
             }
         }
-    }
+    });
+
+    std::vector<std::pair<uint,uint>> all_hits;
+    for(const auto & local : hits) all_hits.insert(all_hits.end(), local.begin(), local.end());
+    tbb::parallel_sort(all_hits.begin(), all_hits.end());
+
+    // each leaf appends its own run of hits
+    tbb::parallel_for((size_t)0, all_hits.size(), [&](size_t i)
+    {
+        uint leaf_id = all_hits[i].first;
+        if(i>0 && all_hits[i-1].first == leaf_id) return;
+        FOctreeBuildNode & leaf = build_nodes[leaf_id];
+        for(size_t j=i; j<all_hits.size() && all_hits[j].first == leaf_id; ++j)
+            leaf.item_indices.push_back(all_hits[j].second);
+    });
 }
 
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 CINO_INLINE
-void FOctree::subdivide(int node_id, tbb::spin_mutex& mutex)
+void FOctree::compact()
 {
-    // create children octants
-    auto node = &nodes[node_id];
-    vec3d min = node->bbox.min;
-    vec3d max = node->bbox.max;
-    vec3d avg = node->bbox.center();
-    {
-        std::lock_guard<tbb::spin_mutex> lock(mutex);
-        node->start = (int)nodes.size();
-        nodes.emplace_back(AABB(vec3d(min[0], min[1], min[2]), vec3d(avg[0], avg[1], avg[2])));
-        nodes.emplace_back(AABB(vec3d(avg[0], min[1], min[2]), vec3d(max[0], avg[1], avg[2])));
-        nodes.emplace_back(AABB(vec3d(avg[0], avg[1], min[2]), vec3d(max[0], max[1], avg[2])));
-        nodes.emplace_back(AABB(vec3d(min[0], avg[1], min[2]), vec3d(avg[0], max[1], avg[2])));
-        nodes.emplace_back(AABB(vec3d(min[0], min[1], avg[2]), vec3d(avg[0], avg[1], max[2])));
-        nodes.emplace_back(AABB(vec3d(avg[0], min[1], avg[2]), vec3d(max[0], avg[1], max[2])));
-        nodes.emplace_back(AABB(vec3d(avg[0], avg[1], avg[2]), vec3d(max[0], max[1], max[2])));
-        nodes.emplace_back(AABB(vec3d(min[0], avg[1], avg[2]), vec3d(avg[0], max[1], max[2])));
+    // only the nodes reachable from the root are kept (refit leaves the merged subtrees behind), numbered
+    // breadth first, so that the 8 children of each inner node stay consecutive
+    std::vector<uint> order = {0}; // build node of each node
+    nodes.clear();
+    nodes.reserve(build_nodes.size());
+    uint num_slots = 0;
+    for(uint i=0; i<order.size(); ++i)
+    {
+        const FOctreeBuildNode & b = build_nodes[order[i]];
+        FOctreeNode & n = nodes.emplace_back();
+        n.bbox = b.bbox;
+        if(b.is_inner)
+        {
+            n.start = (uint)order.size();
+            n.count = FOctreeNode::INNER;
+            for(uint j=0; j<8; ++j) order.push_back(b.start + j);
+        }
+        else
+        {
+            // leaf item lists go one after the other, in node order
+            n.start = num_slots;
+            n.count = (uint)b.item_indices.size();
+            num_slots += n.count;
+        }
     }
-    node->is_inner = true;
 
-    for(uint it : node->item_indices)
+    leaf_items.resize(num_slots);
+    tbb::parallel_for((uint)0, (uint)nodes.size(), [&](uint i)
+    {
+        if(nodes[i].is_inner()) return;
+        const FOctreeBuildNode & b = build_nodes[order[i]];
+        std::copy(b.item_indices.begin(), b.item_indices.end(), leaf_items.begin() + nodes[i].start);
+    });
+
+    build_nodes.clear();
+    build_nodes.shrink_to_fit();
+    boxes = nullptr;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+CINO_INLINE
+void FOctree::subdivide(uint node_id)
+{
+    // create children octants. grow_by reserves 8 consecutive slots atomically, and
+    // never moves the nodes other tasks are working on
+    FOctreeBuildNode & node = build_nodes[node_id];
+    vec3d min = node.bbox.min;
+    vec3d max = node.bbox.max;
+    vec3d avg = node.bbox.center();
+    auto it = build_nodes.grow_by(8);
+    node.start = (int)(it - build_nodes.begin());
+    it[0].bbox = AABB(vec3d(min[0], min[1], min[2]), vec3d(avg[0], avg[1], avg[2]));
+    it[1].bbox = AABB(vec3d(avg[0], min[1], min[2]), vec3d(max[0], avg[1], avg[2]));
+    it[2].bbox = AABB(vec3d(avg[0], avg[1], min[2]), vec3d(max[0], max[1], avg[2]));
+    it[3].bbox = AABB(vec3d(min[0], avg[1], min[2]), vec3d(avg[0], max[1], avg[2]));
+    it[4].bbox = AABB(vec3d(min[0], min[1], avg[2]), vec3d(avg[0], avg[1], max[2]));
+    it[5].bbox = AABB(vec3d(avg[0], min[1], avg[2]), vec3d(max[0], avg[1], max[2]));
+    it[6].bbox = AABB(vec3d(avg[0], avg[1], avg[2]), vec3d(max[0], max[1], max[2]));
+    it[7].bbox = AABB(vec3d(min[0], avg[1], avg[2]), vec3d(avg[0], max[1], max[2]));
+
+    for(uint item : node.item_indices)
     {
         bool orphan = true;
         for(int i=0; i<8; ++i)
         {
-            auto child = &nodes[node->start + i];
-            if(child->bbox.intersects_box(items[it].aabb))
+            if(it[i].bbox.intersects_box((*boxes)[item]))
             {
-                child->item_indices.push_back(it);
+                it[i].item_indices.push_back(item);
                 orphan = false;
             }
         }
         assert(!orphan);
     }
 
-    node->item_indices.clear();
-    node->is_inner = true;
+    node.item_indices.clear();
+    node.is_inner = true;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+CINO_INLINE
+bool FOctree::owns_pair(const FOctreeNode & leaf, const AABB & root, const AABB & b0, const AABB & b1)
+{
+    // the corner is inside both AABBs, so the leaf containing it has both items
+    // (items are assigned to all the children their AABB touches)
+    for(int i=0; i<3; ++i)
+    {
+        double c = std::max(b0.min[i], b1.min[i]);
+        if(c < leaf.bbox.min[i]) return false;
+        if(c >= leaf.bbox.max[i] && leaf.bbox.max[i] != root.max[i]) return false; // no leaves beyond the root
+    }
+    return true;
+}
+
+//::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+CINO_INLINE
+AABB FOctree::root_bbox(const std::vector<AABB> & boxes)
+{
+    AABB bbox;
+    for(auto& b : boxes) bbox.push(b);
+    bbox.scale(1.5);
+
+    vec3d delta = bbox.delta();
+    double pad = 0.5 * std::max(delta[0], std::max(delta[1], delta[2]));
+    for(int i=0; i<3; ++i)
+    {
+        if(delta[i] > 0) continue;
+        double p = (pad > 0) ? pad : std::max(1.0, std::fabs(bbox.min[i])); // all the items in a point
+        bbox.min[i] -= p;
+        bbox.max[i] += p;
+    }
+    return bbox;
 }
 
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
@@ -227,7 +577,7 @@ bool FOctree::intersects_triangle(const vec3d t1[],
                                   double * min,
                                   double * perm,
                                   double * t_min,
-                                  double * t_perm) const
+                                  double * t_perm)
  {
      auto res = triangle_triangle_intersect_3d(t1[0].ptr(), t1[1].ptr(), t1[2].ptr(), t2[0].ptr(), t2[1].ptr(), t2[2].ptr(),min, perm, t_min, t_perm);
      if(ignore_if_valid_complex) return (res > SIMPLICIAL_COMPLEX);
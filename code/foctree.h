@@ -43,6 +43,8 @@
 #include <queue>
 
 #include <absl/container/inlined_vector.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/task_group.h>
 
 template<typename T>
 using onvector = absl::InlinedVector<T, 16>;
@@ -50,28 +52,52 @@ using onvector = absl::InlinedVector<T, 16>;
 namespace cinolib
 {
 
+// leaves and inner nodes share the same compact layout (one cache line). Children of an inner node are
+// consecutive in FOctree::nodes, and the items of a leaf are consecutive in FOctree::leaf_items
 class FOctreeNode
 {
     public:
-        FOctreeNode(const AABB & bbox) : bbox(bbox) {}
+        static const uint INNER = 0xffffffff;
+
+        AABB bbox;
+        uint start = 0;     // inner node: first child. Leaf: first item in FOctree::leaf_items
+        uint count = INNER; // number of items of a leaf, INNER for inner nodes
+
+        bool is_inner() const { return count == INNER; }
+};
+
+// node used only while building the tree, when leaves still have to grow their item lists
+class FOctreeBuildNode
+{
+    public:
+        FOctreeBuildNode() {}
+        FOctreeBuildNode(const AABB & bbox) : bbox(bbox) {}
         AABB              bbox;
         int               start = 0;
-        onvector<uint>    item_indices; // index FOctree::items, avoiding to store a copy of the same object multiple times in each node it appears
+        onvector<uint>    item_indices; // indices of the items, whose AABBs are owned by the caller of FOctree::build
         bool              is_inner = false;
 };
-// due to the bool flag this struct requires 7 bytes padding. Also the
-// pointer to the father is not necessary and could be removed, shrinking it.
-// It could be designed better....
-// https://stackoverflow.com/questions/4306186/structure-padding-and-packing
-// http://www.catb.org/esr/structure-packing/
+
+// leaf created by FOctree::build_morton, with the range of its items in the sorted Morton codes
+struct FOctreeMortonLeaf
+{
+    uint node_id;
+    uint begin;
+    uint end;
+};
 
 //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
 /* Usage:
  *
  *  i)   Create an empty octree
- *  ii)  Use the push_segment/triangle/tetrahedron facilities to populate it
- *  iii) Call build to make the tree
+ *  ii)  Call build with the AABBs of the items. The tree only stores item
+ *       indices, so the AABBs (and any other item data) stay with the caller
+ *
+ * build_morton gives a tree with the same root, cells and depth limit, and each item is in all the
+ * leaves its AABB touches as well. The layout differs though: a node is split on the number of item
+ * centers falling in it, which are found by sorting their Morton codes, instead of the number of
+ * items touching it, so the leaves are not the same of build
 */
 
 class FOctree
@@ -85,51 +111,77 @@ class FOctree
 
         //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-        void build(uint max_depth, uint items_per_leaf, bool parallel);
-        void build_recursive(uint max_depth, uint items_per_leaf, int node_id, int depth, tbb::spin_mutex& mutex, tbb::task_group& group);
+        void build(const std::vector<AABB> & boxes, uint max_depth, uint items_per_leaf, bool parallel);
+        void build_recursive(uint max_depth, uint items_per_leaf, uint node_id, uint depth, tbb::task_group& group);
+
+        // items are sorted by the 63-bit Morton code of their center (21 bits per axis, so at most 22
+        // levels), and the children of a node are the sub-ranges sharing the next 3 bits. A node is split
+        // if more than items_per_leaf centers fall in it: the leaves may hold more items than that,
+        // because an item crossing the boundary of its cell is also added to the neighbouring leaves
+        void build_morton(const std::vector<AABB> & boxes, uint max_depth, uint items_per_leaf);
+        void build_morton_recursive(uint max_depth, uint items_per_leaf, uint node_id, uint depth, uint begin, uint end,
+                                    const std::vector<uint64_t> & codes, tbb::concurrent_vector<FOctreeMortonLeaf> & leaves,
+                                    tbb::task_group & group);
+
+        // updates the tree after the AABBs of the items in moved changed (boxes has the AABBs of all the
+        // items, with the ids of the last build). The moved items are removed from their leaves and
+        // inserted again from the root. Then each subtree is rebuilt locally if its occupancy drifted
+        // too far: subtrees left with at most items_per_leaf/2 items are merged into a leaf, and leaves
+        // with more than twice their items at build time (and than 2*items_per_leaf) are subdivided as
+        // in build. Within these margins the tree is kept as it is, so it can be deeper or shallower
+        // than a new build. The root is kept, so returns false (leaving the tree untouched) if a moved
+        // item got out of it
+        bool refit(const std::vector<AABB> & boxes, const std::vector<uint> & moved);
 
         //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-        void subdivide(int node_id, tbb::spin_mutex& mutex);
+        // safe to call concurrently on different nodes: the 8 children are appended with a single
+        // atomic grow of build_nodes, whose elements never move
+        void subdivide(uint node_id);
 
         //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
-        void build_from_vectors(const std::vector<vec3d> & verts,
-                                const std::vector<uint>  & tris,
-                                uint max_depth, uint items_per_leaf,
-                                bool parallel)
-        {
-            assert(items.empty());
-            items.reserve(tris.size()/3);
-            for(uint i=0; i<tris.size(); i+=3)
-            {
-                items.emplace_back(i/3, verts.at(tris[i  ]),
-                                    verts.at(tris[i+1]),
-                                    verts.at(tris[i+2]));
-            }
-            build(max_depth, items_per_leaf, parallel);
-        }
-
         std::vector<int> get_leaves() const;
 
-        // all items live here, and leaf nodes only store indices to items
-        std::vector<Triangle> items;
-        std::vector<FOctreeNode> nodes;
+        size_t memory_usage() const; // approximate heap bytes of nodes and leaf item lists
 
-        bool intersects_triangle(const vec3d   t1[],
-                                 const vec3d   t2[],
-                                 const bool ignore_if_valid_complex,
-                                 double * min = NULL,
-                                 double * perm = NULL,
-                                 double * t_min = NULL,
-                                 double * t_perm = NULL) const;
+        std::vector<FOctreeNode> nodes;
+        std::vector<uint>        leaf_items; // item lists of all the leaves, one after the other
+
+        // true if leaf is the one in charge of testing the items with AABBs b0 and b1, i.e. the leaf
+        // containing the min corner of their intersection. Leaves are half-open boxes (closed on the
+        // max faces of the root), so each pair of overlapping items found in many leaves is tested
+        // exactly once
+        static bool owns_pair(const FOctreeNode & leaf, const AABB & root, const AABB & b0, const AABB & b1);
+
+        static bool intersects_triangle(const vec3d   t1[],
+                                        const vec3d   t2[],
+                                        const bool ignore_if_valid_complex,
+                                        double * min = NULL,
+                                        double * perm = NULL,
+                                        double * t_min = NULL,
+                                        double * t_perm = NULL);
 
         //::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
 
         protected:
 
+        // flattens the nodes of build_nodes reachable from the root into nodes and leaf_items
+        void compact();
+
+        // AABB of all the items enlarged by 1.5. Axes with no extent (e.g. planar inputs) are enlarged
+        // too, otherwise the children of each node would coincide along them
+        static AABB root_bbox(const std::vector<AABB> & boxes);
+
+        // adds each item to all the leaves of build_nodes its AABB touches
+        void insert_items(const std::vector<uint> & items);
+
         uint max_depth;      // maximum allowed depth of the tree
         uint items_per_leaf; // prescribed number of items per leaf (can't go deeper than max_depth anyways)
+
+        // only valid during build
+        const std::vector<AABB> *                    boxes = nullptr;
+        tbb::concurrent_vector<FOctreeBuildNode>     build_nodes;
 };
 
 }
@@ -0,0 +1,281 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "octree_broadphase.h"
+#include "pipeline_control.h"
+
+#include <stack>
+#include <algorithm>
+
+inline OctreeParameters tuneOctreeParameters(const std::vector<cinolib::AABB> &boxes, double max_cells_per_item)
+{
+    const uint max_levels = 21; // as many as the Morton codes of FOctree::build_morton can split
+    const uint max_sample = 4096;
+
+    cinolib::AABB root;
+    for(const cinolib::AABB &b : boxes) root.push(b);
+    root.scale(1.5); // as done by FOctree
+    cinolib::vec3d root_delta = root.delta();
+
+    // extent of the sampled items relative to the root, along each axis
+    uint num_items = static_cast<uint>(boxes.size());
+    uint step = std::max(1u, num_items / max_sample);
+    std::vector<cinolib::vec3d> sizes;
+    for(uint i = 0; i < num_items; i += step)
+    {
+        cinolib::vec3d delta = boxes[i].delta();
+        for(int k = 0; k < 3; k++) delta[k] = root_delta[k] > 0 ? delta[k] / root_delta[k] : 0.0;
+        sizes.push_back(delta);
+    }
+
+    // number of cells of depth d touched by an item of relative size r
+    auto touched_cells = [](const cinolib::vec3d &r, uint d)
+    {
+        double splits = static_cast<double>(1u << (d - 1));
+        return (1.0 + r[0] * splits) * (1.0 + r[1] * splits) * (1.0 + r[2] * splits);
+    };
+
+    OctreeParameters p = {2, 256};
+    if(sizes.empty()) return p;
+
+    double avg_cells = 0.0;
+    for(uint d = 2; d <= max_levels; d++)
+    {
+        double sum = 0.0;
+        for(const cinolib::vec3d &r : sizes) sum += touched_cells(r, d);
+        if(sum / sizes.size() > max_cells_per_item) break;
+        p.max_depth = d;
+        avg_cells = sum / sizes.size();
+    }
+
+    // skew of the item sizes at the chosen depth: the average over the median number of touched cells.
+    // It is about 1 for scanned meshes, while a few long triangles (CAD) push the average up
+    std::vector<double> cells(sizes.size());
+    for(uint i = 0; i < sizes.size(); i++) cells[i] = touched_cells(sizes[i], p.max_depth);
+    std::nth_element(cells.begin(), cells.begin() + cells.size() / 2, cells.end());
+    double skew = avg_cells / cells[cells.size() / 2];
+
+    while(p.items_per_leaf < 1024 && skew >= 1.25)
+    {
+        p.items_per_leaf *= 2;
+        skew /= 1.25;
+    }
+    return p;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline OctreeBroadphase::OctreeBroadphase(uint max_depth, uint items_per_leaf, bool morton)
+    : max_depth(max_depth), items_per_leaf(items_per_leaf), morton(morton)
+{}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline BroadphaseType OctreeBroadphase::type() const
+{
+    return morton ? BROADPHASE_MORTON : BROADPHASE_OCTREE;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void OctreeBroadphase::build(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris)
+{
+    initItems(verts, tris);
+
+    params = {max_depth, items_per_leaf};
+    if(max_depth == 0 || items_per_leaf == 0)
+    {
+        OctreeParameters tuned = tuneOctreeParameters(boxes);
+        if(max_depth == 0)      params.max_depth = tuned.max_depth;
+        if(items_per_leaf == 0) params.items_per_leaf = tuned.items_per_leaf;
+    }
+
+    if(morton) octree.build_morton(boxes, params.max_depth, params.items_per_leaf);
+    else       octree.build(boxes, params.max_depth, params.items_per_leaf, true);
+    if(octree.nodes.empty()) return;
+    box = octree.nodes[0].bbox;
+    built_nodes = static_cast<uint>(octree.nodes.size());
+
+    prepareLeaves();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool OctreeBroadphase::refit(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris)
+{
+    std::vector<uint> moved;
+    if(octree.nodes.empty() || !refitItems(verts, tris, moved)) return false;
+    if(moved.empty()) return true;
+
+    if(!octree.refit(boxes, moved)) return false;
+    if(octree.nodes.size() > 2 * static_cast<size_t>(built_nodes)) return false; // too far from the data
+
+    prepareLeaves();
+    return true;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void OctreeBroadphase::prepareLeaves()
+{
+    uint num_nodes = static_cast<uint>(octree.nodes.size());
+    leaf_bounds.resize(static_cast<uint>(octree.leaf_items.size()));
+    sweep_axis.assign(num_nodes, 0);
+
+    tbb::parallel_for((uint)0, num_nodes, [&](uint n)
+    {
+        const cinolib::FOctreeNode &node = octree.nodes[n];
+        if(node.is_inner() || node.count == 0) return;
+
+        // sweep along the axis where the items are most spread
+        uint *slots = octree.leaf_items.data() + node.start;
+        cinolib::AABB spread;
+        for(uint s = 0; s < node.count; s++) spread.push(boxes[slots[s]].min);
+        cinolib::vec3d extent = spread.delta();
+        uint axis = (extent.x() >= extent.y() && extent.x() >= extent.z()) ? 0 : (extent.y() >= extent.z() ? 1 : 2);
+        sweep_axis[n] = static_cast<uint8_t>(axis);
+
+        std::sort(slots, slots + node.count, [&](uint t0, uint t1)
+        {
+            double m0 = boxes[t0].min[axis], m1 = boxes[t1].min[axis];
+            return m0 < m1 || (m0 == m1 && t0 < t1);
+        });
+
+        for(uint s = node.start; s < node.start + node.count; s++)
+            leaf_bounds.set(s, boxes[octree.leaf_items[s]]);
+    });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void OctreeBroadphase::visitOverlappingPairs(PairVisitor &visitor, const std::atomic<bool> *cancel) const
+{
+    std::vector<int> leaves = octree.get_leaves();
+
+    tbb::parallel_for((uint)0, (uint)leaves.size(), [&](uint i)
+    {
+        if(isCancelled(cancel)) return;
+
+        uint n = leaves[i];
+        const cinolib::FOctreeNode &leaf = octree.nodes[n];
+        uint axis = sweep_axis[n];
+        const std::vector<double> &slot_min = leaf_bounds.min(axis);
+
+        // the slots are sorted along axis: only the items starting before the end of tid0 can overlap it
+        uint leaf_end = leaf.start + leaf.count;
+        for(uint j = leaf.start; j < leaf_end; ++j)
+        {
+            uint tid0 = octree.leaf_items[j];
+            const cinolib::AABB &b0 = boxes[tid0];
+            uint end = j + 1;
+            while(end < leaf_end && slot_min[end] <= b0.max[axis]) end++;
+
+            leaf_bounds.forEachOverlap(b0, j + 1, end, [&](uint s) // early reject based on AABB intersection
+            {
+                uint tid1 = octree.leaf_items[s];
+                if(cinolib::FOctree::owns_pair(leaf, octree.nodes[0].bbox, b0, boxes[tid1])) // other leaves containing both are skipped
+                    visitor.visit(tid0, tid1);
+            });
+        }
+    });
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool OctreeBroadphase::intersectsBox(const cinolib::AABB &b, phmap::flat_hash_set<uint> &ids) const
+{
+    if(octree.nodes.empty()) return false;
+
+    std::stack<uint> lifo;
+    if(octree.nodes[0].bbox.intersects_box(b))
+    {
+        lifo.push(0);
+    }
+
+    while(!lifo.empty())
+    {
+        uint n = lifo.top();
+        const cinolib::FOctreeNode &node = octree.nodes[n];
+        lifo.pop();
+        assert(node.bbox.intersects_box(b));
+
+        if(node.is_inner())
+        {
+            for(int i=0; i<8; ++i)
+            {
+                if(octree.nodes[node.start + i].bbox.intersects_box(b))
+                {
+                    lifo.push(node.start + i);
+                }
+            }
+        }
+        else
+        {
+            leaf_bounds.forEachOverlap(b, node.start, node.start + node.count, [&](uint s){ ids.insert(octree.leaf_items[s]); });
+        }
+    }
+
+    return !ids.empty();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline uint OctreeBroadphase::numNodes() const
+{
+    return static_cast<uint>(octree.nodes.size());
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline size_t OctreeBroadphase::memoryUsage() const
+{
+    return itemsMemoryUsage() + octree.memory_usage() + leaf_bounds.memoryUsage() + sweep_axis.capacity();
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline const cinolib::FOctree &OctreeBroadphase::tree() const
+{
+    return octree;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline OctreeParameters OctreeBroadphase::parameters() const
+{
+    return params;
+}
@@ -0,0 +1,112 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_OCTREE_BROADPHASE_H
+#define EXACT_BOOLEANS_OCTREE_BROADPHASE_H
+
+#include "broadphase.h"
+#include "foctree.h"
+#include "aabb_array.h"
+
+// parameters of FOctree::build and FOctree::build_morton
+struct OctreeParameters
+{
+    uint max_depth;
+    uint items_per_leaf;
+};
+
+// picks the octree parameters from a sample of the item AABBs. A cell at depth d spans 1/2^(d-1) of the
+// root along each axis, so the number of cells an item touches at that depth follows from its extent
+// relative to the root: max_depth is the deepest level where the sampled items touch at most
+// max_cells_per_item cells on average, which keeps the leaves from being refined below the size of
+// the triangles. Leaves are made larger when a few big triangles dominate that average (e.g. CAD
+// models with long faces next to small fillets), since refining them only duplicates the big items
+inline OctreeParameters tuneOctreeParameters(const std::vector<cinolib::AABB> &boxes, double max_cells_per_item = 2.0);
+
+// Broadphase backend based on FOctree: items are assigned to all the leaves they overlap, and each
+// overlapping pair is reported only by the leaf owning it (see FOctree::owns_pair). Pairs are
+// found by sorting and sweeping the items of each leaf. With morton set the tree is built from the
+// sorted Morton codes of the items (see FOctree::build_morton), and the backend is BROADPHASE_MORTON.
+// Parameters set to 0 are chosen at each build with tuneOctreeParameters
+class OctreeBroadphase : public Broadphase
+{
+    public:
+
+        inline explicit OctreeBroadphase(uint max_depth = 0, uint items_per_leaf = 0, bool morton = false);
+
+        inline BroadphaseType type() const override;
+
+        inline void build(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris) override;
+
+        // moved items are re-inserted in the octree of the last build (see FOctree::refit), keeping its
+        // parameters. Falls back to build if the tree doubled its nodes since then
+        inline bool refit(const std::vector<cinolib::vec3d> &verts, const std::vector<uint> &tris) override;
+
+        inline void visitOverlappingPairs(PairVisitor &visitor, const std::atomic<bool> *cancel = nullptr) const override;
+
+        inline bool intersectsBox(const cinolib::AABB &b, phmap::flat_hash_set<uint> &ids) const override;
+
+        inline uint numNodes() const override;
+
+        inline size_t memoryUsage() const override;
+
+        inline const cinolib::FOctree &tree() const;
+
+        inline OctreeParameters parameters() const; // the ones used by the last build
+
+    private:
+
+        // sorts the items of each leaf and fills leaf_bounds and sweep_axis
+        inline void prepareLeaves();
+
+        cinolib::FOctree octree;
+
+        // the item list of each leaf (a range of octree.leaf_items) is sorted along the sweep axis of
+        // the leaf, and the bounds of its items are copied in the same order, so that the overlap tests
+        // run on contiguous bounds
+        AABBArray            leaf_bounds;  // bounds of each entry of octree.leaf_items
+        std::vector<uint8_t> sweep_axis;   // for each node
+        uint max_depth;      // 0 to tune it at each build
+        uint items_per_leaf; // 0 to tune it at each build
+        bool morton;
+        OctreeParameters params = {0, 0};
+        uint built_nodes = 0; // nodes of the last build, before any refit
+};
+
+#include "octree_broadphase.cpp"
+
+#endif // EXACT_BOOLEANS_OCTREE_BROADPHASE_H
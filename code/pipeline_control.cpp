@@ -0,0 +1,140 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "pipeline_control.h"
+
+inline void PipelineControl::cancel()
+{
+    cancelled.store(true, std::memory_order_relaxed);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void PipelineControl::reset()
+{
+    cancelled.store(false, std::memory_order_relaxed);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool PipelineControl::isCancelled() const
+{
+    return cancelled.load(std::memory_order_relaxed);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline const std::atomic<bool> &PipelineControl::cancelFlag() const
+{
+    return cancelled;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void PipelineControl::setProgressCallback(const ProgressCallback &callback)
+{
+    progress_callback = callback;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void PipelineControl::setStageRange(PipelineStage first, PipelineStage last)
+{
+    assert(first <= last && last < NUM_PIPELINE_STAGES);
+    first_stage = first;
+    last_stage  = last;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool PipelineControl::stageCompleted(PipelineStage stage)
+{
+    if(isCancelled()) return false;
+
+    if(progress_callback)
+        progress_callback(stage, static_cast<double>(stage - first_stage + 1) / (last_stage - first_stage + 1));
+
+    return !isCancelled(); // the callback itself may cancel the run
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool stageCompleted(PipelineControl *control, PipelineStage stage)
+{
+    return (control == nullptr) || control->stageCompleted(stage);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void setStageRange(PipelineControl *control, PipelineStage first, PipelineStage last)
+{
+    if(control) control->setStageRange(first, last);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline const std::atomic<bool> *cancelFlag(const PipelineControl *control)
+{
+    return (control) ? &control->cancelFlag() : nullptr;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool isCancelled(const std::atomic<bool> *cancel_flag)
+{
+    return cancel_flag && cancel_flag->load(std::memory_order_relaxed);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline const char *stageName(PipelineStage stage)
+{
+    switch(stage)
+    {
+        case STAGE_MERGE:              return "merge";
+        case STAGE_DEGENERATE_REMOVAL: return "degenerate_removal";
+        case STAGE_TRIANGLE_SOUP:      return "triangle_soup";
+        case STAGE_BROADPHASE:         return "broadphase";
+        case STAGE_CLASSIFICATION:     return "classification";
+        case STAGE_TRIANGULATION:      return "triangulation";
+        case STAGE_PATCHES:            return "patches";
+        case STAGE_INSIDE_OUT:         return "inside_out";
+        case STAGE_SELECTION:          return "selection";
+        case STAGE_OUTPUT:             return "output";
+        default:                       return "unknown";
+    }
+}
@@ -0,0 +1,120 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_PIPELINE_CONTROL_H
+#define EXACT_BOOLEANS_PIPELINE_CONTROL_H
+
+#include <atomic>
+#include <cassert>
+#include <functional>
+
+enum PipelineStage
+{
+    STAGE_MERGE,
+    STAGE_DEGENERATE_REMOVAL,
+    STAGE_TRIANGLE_SOUP,
+    STAGE_BROADPHASE,
+    STAGE_CLASSIFICATION,
+    STAGE_TRIANGULATION,
+    STAGE_PATCHES,
+    STAGE_INSIDE_OUT,
+    STAGE_SELECTION,
+    STAGE_OUTPUT,
+    NUM_PIPELINE_STAGES
+};
+
+/* Cooperative cancellation and progress reporting for a run of the boolean pipeline. Pass a pointer to
+ * booleanPipeline (or to BooleanSession::init): cancel() can be called from any thread, the pipeline
+ * checks the flag between stages and inside its long parallel loops, and returns false as soon as it
+ * notices it. The results of a cancelled run are left in an unspecified state and must be discarded
+*/
+
+class PipelineControl
+{
+    public:
+
+        // stage just completed and fraction (0..1] of the stages run by the current call completed so far
+        // (see setStageRange). Called by the thread running the pipeline, so it should be cheap
+        typedef std::function<void(PipelineStage stage, double progress)> ProgressCallback;
+
+        inline PipelineControl() {}
+
+        inline explicit PipelineControl(const ProgressCallback &callback) : progress_callback(callback) {}
+
+        PipelineControl(const PipelineControl &) = delete;
+        PipelineControl &operator=(const PipelineControl &) = delete;
+
+        inline void cancel();
+
+        inline void reset();
+
+        inline bool isCancelled() const;
+
+        // the flag checked by the parallel loops (see triangulation in the arrangements library)
+        inline const std::atomic<bool> &cancelFlag() const;
+
+        inline void setProgressCallback(const ProgressCallback &callback);
+
+        // stages run by the current call, set by the functions starting a run: the whole pipeline for
+        // booleanPipeline, STAGE_MERGE..STAGE_INSIDE_OUT for BooleanSession::init
+        inline void setStageRange(PipelineStage first, PipelineStage last);
+
+        // reports the end of stage, returns false if the pipeline has to stop
+        inline bool stageCompleted(PipelineStage stage);
+
+    private:
+
+        std::atomic<bool> cancelled{false};
+        ProgressCallback  progress_callback;
+        PipelineStage     first_stage = STAGE_MERGE;
+        PipelineStage     last_stage  = STAGE_OUTPUT;
+};
+
+// helpers accepting a null control, as passed by the pipeline functions
+inline bool stageCompleted(PipelineControl *control, PipelineStage stage);
+
+inline void setStageRange(PipelineControl *control, PipelineStage first, PipelineStage last);
+
+inline const std::atomic<bool> *cancelFlag(const PipelineControl *control);
+
+inline bool isCancelled(const std::atomic<bool> *cancel_flag);
+
+inline const char *stageName(PipelineStage stage);
+
+#include "pipeline_control.cpp"
+
+#endif // EXACT_BOOLEANS_PIPELINE_CONTROL_H
@@ -0,0 +1,194 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "pipeline_stats.h"
+
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+inline double lapTime(std::chrono::steady_clock::time_point &t)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(now - t).count();
+    t = now;
+    return s;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline size_t peakRSS()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return static_cast<size_t>(pmc.PeakWorkingSetSize);
+#else
+    struct rusage ru;
+    if(getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(ru.ru_maxrss);        // bytes on macOS
+#else
+    return static_cast<size_t>(ru.ru_maxrss) * 1024; // kilobytes on Linux
+#endif
+#endif
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline size_t currentRSS()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return static_cast<size_t>(pmc.WorkingSetSize);
+#elif defined(__linux__)
+    // second field of statm: resident pages
+    FILE *f = std::fopen("/proc/self/statm", "r");
+    if(!f) return 0;
+    unsigned long size = 0, resident = 0;
+    int n = std::fscanf(f, "%lu %lu", &size, &resident);
+    std::fclose(f);
+    if(n != 2) return 0;
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::ptrdiff_t lapRSS(PipelineStats &stats)
+{
+    size_t rss = currentRSS();
+    std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(rss) - static_cast<std::ptrdiff_t>(stats.rss);
+    stats.rss = rss;
+    return delta;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::string statsToJSON(const PipelineStats &stats)
+{
+    std::ostringstream s;
+
+    s << "{\n"
+      << "  \"time\": {\n"
+      << "    \"merge\": "              << stats.merge_time              << ",\n"
+      << "    \"degenerate_removal\": " << stats.degenerate_removal_time << ",\n"
+      << "    \"triangle_soup\": "      << stats.triangle_soup_time      << ",\n"
+      << "    \"octree\": "             << stats.octree_time             << ",\n"
+      << "    \"broadphase\": "         << stats.broadphase_time         << ",\n"
+      << "    \"classification\": "     << stats.classification_time     << ",\n"
+      << "    \"triangulation\": "      << stats.triangulation_time      << ",\n"
+      << "    \"patches\": "            << stats.patches_time            << ",\n"
+      << "    \"inside_out\": "         << stats.inside_out_time         << ",\n"
+      << "    \"selection\": "          << stats.selection_time          << ",\n"
+      << "    \"output\": "             << stats.output_time             << ",\n"
+      << "    \"total\": "              << stats.total_time              << "\n"
+      << "  },\n"
+      << "  \"count\": {\n"
+      << "    \"input_verts\": "        << stats.num_input_verts         << ",\n"
+      << "    \"input_tris\": "         << stats.num_input_tris          << ",\n"
+      << "    \"tri_tri_tests\": "      << stats.num_tri_tri_tests       << ",\n"
+      << "    \"same_label_pairs\": "   << stats.num_same_label_pairs    << ",\n"
+      << "    \"filtered_pairs\": "     << stats.num_filtered_pairs      << ",\n"
+      << "    \"intersecting_pairs\": " << stats.num_intersecting_pairs  << ",\n"
+      << "    \"lpi_points\": "         << stats.num_lpi_points          << ",\n"
+      << "    \"tpi_points\": "         << stats.num_tpi_points          << ",\n"
+      << "    \"split_tris\": "         << stats.num_split_tris          << ",\n"
+      << "    \"arrangement_tris\": "   << stats.num_arrangement_tris    << ",\n"
+      << "    \"patches\": "            << stats.num_patches             << ",\n"
+      << "    \"rays\": "               << stats.num_rays                << ",\n"
+      << "    \"ray_perturbations\": "  << stats.num_ray_perturbations   << ",\n"
+      << "    \"output_tris\": "        << stats.num_output_tris         << "\n"
+      << "  },\n"
+      << "  \"memory\": {\n"
+      << "    \"arena_bytes\": "         << stats.arena_bytes             << ",\n"
+      << "    \"arena_buckets\": "       << stats.arena_buckets           << ",\n"
+      << "    \"aux_structure_bytes\": " << stats.aux_structure_bytes     << ",\n"
+      << "    \"octree_bytes\": "        << stats.octree_bytes            << ",\n"
+      << "    \"octree_nodes\": "        << stats.octree_nodes            << ",\n"
+      << "    \"octree_items\": "        << stats.octree_items            << ",\n"
+      << "    \"patches_bytes\": "       << stats.patches_bytes           << ",\n"
+      << "    \"labels_bytes\": "        << stats.labels_bytes            << "\n"
+      << "  },\n"
+      << "  \"octree\": {\n"
+      << "    \"max_depth\": "      << stats.octree_max_depth      << ",\n"
+      << "    \"items_per_leaf\": " << stats.octree_items_per_leaf << ",\n"
+      << "    \"refit\": "          << stats.octree_refit          << "\n"
+      << "  },\n"
+      << "  \"peak_rss\": {\n"
+      << "    \"merge\": "              << stats.merge_peak_rss              << ",\n"
+      << "    \"degenerate_removal\": " << stats.degenerate_removal_peak_rss << ",\n"
+      << "    \"triangle_soup\": "      << stats.triangle_soup_peak_rss      << ",\n"
+      << "    \"octree\": "             << stats.octree_peak_rss             << ",\n"
+      << "    \"broadphase\": "         << stats.broadphase_peak_rss         << ",\n"
+      << "    \"classification\": "     << stats.classification_peak_rss     << ",\n"
+      << "    \"triangulation\": "      << stats.triangulation_peak_rss      << ",\n"
+      << "    \"patches\": "            << stats.patches_peak_rss            << ",\n"
+      << "    \"inside_out\": "         << stats.inside_out_peak_rss         << ",\n"
+      << "    \"selection\": "          << stats.selection_peak_rss          << ",\n"
+      << "    \"output\": "             << stats.output_peak_rss             << "\n"
+      << "  },\n"
+      << "  \"rss_delta\": {\n"
+      << "    \"merge\": "              << stats.merge_rss_delta              << ",\n"
+      << "    \"degenerate_removal\": " << stats.degenerate_removal_rss_delta << ",\n"
+      << "    \"triangle_soup\": "      << stats.triangle_soup_rss_delta      << ",\n"
+      << "    \"octree\": "             << stats.octree_rss_delta             << ",\n"
+      << "    \"broadphase\": "         << stats.broadphase_rss_delta         << ",\n"
+      << "    \"classification\": "     << stats.classification_rss_delta     << ",\n"
+      << "    \"triangulation\": "      << stats.triangulation_rss_delta      << ",\n"
+      << "    \"patches\": "            << stats.patches_rss_delta            << ",\n"
+      << "    \"inside_out\": "         << stats.inside_out_rss_delta         << ",\n"
+      << "    \"selection\": "          << stats.selection_rss_delta          << ",\n"
+      << "    \"output\": "             << stats.output_rss_delta             << "\n"
+      << "  }\n"
+      << "}\n";
+
+    return s.str();
+}
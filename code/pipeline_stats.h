@@ -0,0 +1,149 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifndef EXACT_BOOLEANS_PIPELINE_STATS_H
+#define EXACT_BOOLEANS_PIPELINE_STATS_H
+
+#include <string>
+#include <chrono>
+#include <cstddef>
+
+typedef unsigned int uint;
+
+/* Timings (wall time, in seconds), workload counters and memory usage (bytes) of a run of the boolean
+ * pipeline. Pass a pointer to booleanPipeline (or to the custom*Pipeline functions) to fill it. Stages that
+ * did not run stay at 0
+*/
+
+struct PipelineStats
+{
+    // arrangement
+    double merge_time              = 0.0; // mergeDuplicatedVertices
+    double degenerate_removal_time = 0.0; // customRemoveDegenerateAndDuplicatedTriangles
+    double triangle_soup_time      = 0.0; // TriangleSoup init
+    double octree_time             = 0.0; // octree build
+    double broadphase_time         = 0.0; // candidate pairs + triangle-triangle tests
+    double classification_time     = 0.0; // classifyIntersections
+    double triangulation_time      = 0.0;
+
+    // booleans
+    double patches_time            = 0.0; // mesh connectivity + computeAllPatches
+    double inside_out_time         = 0.0; // computeInsideOut
+    double selection_time          = 0.0;
+    double output_time             = 0.0; // computeFinalExplicitResult
+    double total_time              = 0.0;
+
+    uint num_input_verts        = 0;
+    uint num_input_tris         = 0;
+    uint num_tri_tri_tests      = 0; // exact triangle-triangle tests in the broadphase (AABB overlap)
+    uint num_same_label_pairs   = 0; // pairs of the same input mesh, skipped by the broadphase
+    uint num_filtered_pairs     = 0; // pairs certified disjoint by the floating point filter, not tested exactly
+    uint num_intersecting_pairs = 0;
+    uint num_lpi_points         = 0;
+    uint num_tpi_points         = 0;
+    uint num_split_tris         = 0; // input triangles re-triangulated because of intersections or coplanarities
+    uint num_arrangement_tris   = 0;
+    uint num_patches            = 0;
+    uint num_rays               = 0;
+    uint num_ray_perturbations  = 0;
+    uint num_output_tris        = 0;
+
+    // approximate heap memory held by the main structures, measured when they are complete
+    size_t arena_bytes          = 0; // implicit and explicit points (point_arena)
+    uint   arena_buckets        = 0;
+    size_t aux_structure_bytes  = 0; // AuxiliaryStructure maps, after the triangulation
+    size_t octree_bytes         = 0; // broadphase items (vertices, ids and AABBs) and index
+    uint   octree_nodes         = 0;
+    uint   octree_items         = 0;
+    size_t patches_bytes        = 0;
+    size_t labels_bytes         = 0; // surface and inside labels of the arrangement triangles
+
+    // broadphase index configuration (not memory)
+    uint   octree_max_depth      = 0; // octree parameters, tuned on the input unless given (0 for the BVH backends)
+    uint   octree_items_per_leaf = 0;
+    uint   octree_refit          = 0; // 1 if the index of the previous run was refitted instead of built
+
+    // peak RSS of the process (not of the stage) at the end of each stage. It never decreases, and it
+    // includes all the jobs running in the same process
+    size_t merge_peak_rss              = 0;
+    size_t degenerate_removal_peak_rss = 0;
+    size_t triangle_soup_peak_rss      = 0;
+    size_t octree_peak_rss             = 0;
+    size_t broadphase_peak_rss         = 0;
+    size_t classification_peak_rss     = 0;
+    size_t triangulation_peak_rss      = 0;
+    size_t patches_peak_rss            = 0;
+    size_t inside_out_peak_rss         = 0;
+    size_t selection_peak_rss          = 0;
+    size_t output_peak_rss             = 0;
+
+    // change of the current RSS of the process during each stage (negative if memory was released).
+    // The stage with the largest delta is the one that makes the job run out of memory, as long as no
+    // other job runs in the same process. 0 where the current RSS is not available
+    std::ptrdiff_t merge_rss_delta              = 0;
+    std::ptrdiff_t degenerate_removal_rss_delta = 0;
+    std::ptrdiff_t triangle_soup_rss_delta      = 0;
+    std::ptrdiff_t octree_rss_delta             = 0;
+    std::ptrdiff_t broadphase_rss_delta         = 0;
+    std::ptrdiff_t classification_rss_delta     = 0;
+    std::ptrdiff_t triangulation_rss_delta      = 0;
+    std::ptrdiff_t patches_rss_delta            = 0;
+    std::ptrdiff_t inside_out_rss_delta         = 0;
+    std::ptrdiff_t selection_rss_delta          = 0;
+    std::ptrdiff_t output_rss_delta             = 0;
+
+    size_t rss = 0; // current RSS at the last lapRSS
+};
+
+// seconds elapsed since t, then t is moved to the current time (to time consecutive stages)
+inline double lapTime(std::chrono::steady_clock::time_point &t);
+
+// peak resident set size of the process, in bytes (0 if not available)
+inline size_t peakRSS();
+
+// current resident set size of the process, in bytes (0 if not available)
+inline size_t currentRSS();
+
+// change of the current RSS since the last call on stats (or since it was reset), then stats.rss is moved
+// to the current RSS (to measure consecutive stages)
+inline std::ptrdiff_t lapRSS(PipelineStats &stats);
+
+inline std::string statsToJSON(const PipelineStats &stats);
+
+#include "pipeline_stats.cpp"
+
+#endif // EXACT_BOOLEANS_PIPELINE_STATS_H
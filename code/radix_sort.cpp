@@ -0,0 +1,97 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#include "radix_sort.h"
+
+#include <algorithm>
+#include <cassert>
+#include <tbb/tbb.h>
+
+inline void parallelRadixSort(std::vector<uint64_t> &keys, std::vector<uint> &values, uint key_bits)
+{
+    assert(keys.size() == values.size());
+    const uint n = static_cast<uint>(keys.size());
+    if(n < 2) return;
+
+    const uint block_size = 1 << 16;
+    const uint num_blocks = (n + block_size - 1) / block_size;
+
+    std::vector<uint64_t> tmp_keys(n);
+    std::vector<uint>     tmp_values(n);
+    std::vector<uint>     offsets(256 * num_blocks); // for each block, the count (then the first slot) of each digit
+
+    for(uint shift = 0; shift < key_bits; shift += 8)
+    {
+        tbb::parallel_for((uint)0, num_blocks, [&](uint b)
+        {
+            uint *count = offsets.data() + 256 * b;
+            std::fill(count, count + 256, 0);
+            uint end = std::min(n, (b + 1) * block_size);
+            for(uint i = b * block_size; i < end; i++) count[(keys[i] >> shift) & 0xff]++;
+        });
+
+        // slots are assigned by digit first and then by block, which keeps the sort stable
+        bool uniform = false;
+        uint sum = 0;
+        for(uint d = 0; d < 256 && !uniform; d++)
+        {
+            uint digit_start = sum;
+            for(uint b = 0; b < num_blocks; b++)
+            {
+                uint c = offsets[256 * b + d];
+                offsets[256 * b + d] = sum;
+                sum += c;
+            }
+            uniform = (sum - digit_start == n);
+        }
+        if(uniform) continue; // the order is already right for this digit
+
+        tbb::parallel_for((uint)0, num_blocks, [&](uint b)
+        {
+            uint *slot = offsets.data() + 256 * b;
+            uint end = std::min(n, (b + 1) * block_size);
+            for(uint i = b * block_size; i < end; i++)
+            {
+                uint s = slot[(keys[i] >> shift) & 0xff]++;
+                tmp_keys[s]   = keys[i];
+                tmp_values[s] = values[i];
+            }
+        });
+        keys.swap(tmp_keys);
+        values.swap(tmp_values);
+    }
+}
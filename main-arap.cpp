@@ -45,7 +45,7 @@
 #include <cinolib/meshes/drawable_trimesh.h>
 #include <cinolib/ARAP.h>
 #include <thread>
-#include "booleans.h"
+#include "boolean_scheduler.h"
 
 std::vector<uint> handles;
 
@@ -140,26 +140,28 @@ int main(int argc, char **argv)
     update_input_coords(in_coords,m1.vector_verts(),0);
     update_input_coords(in_coords,m2.vector_verts(), m1.num_verts() * 3);
 
-    std::vector<double>            bool_coords;
-    std::vector<uint>              bool_tris;
-    std::vector<std::bitset<NBIT>> bool_labels;
-    booleanPipeline(in_coords, in_tris, in_labels, op, bool_coords, bool_tris, bool_labels);
+    // the booleans run on the scheduler thread: each drag event posts the new coordinates and
+    // cancels the computation in flight, which is stale anyway
+    BooleanScheduler scheduler;
+    BooleanFrame frame;
+    scheduler.submit(in_coords, in_tris, in_labels, op);
+
     const cinolib::Color & c0 = cinolib::Color::PASTEL_ORANGE();
     const cinolib::Color & c1 = cinolib::Color::PASTEL_CYAN();
-    uint n_tri = bool_tris.size()/3;
-    std::vector<cinolib::Color> tri_colors(n_tri, c0);
-
-    for(uint id=0; id<n_tri; ++id)
-        if(bool_labels[id][1])
-            tri_colors[id] = c1;
+    std::vector<cinolib::Color> tri_colors;
 
-    cinolib::DrawableTriangleSoup soup(bool_coords, bool_tris, tri_colors);
+    cinolib::DrawableTriangleSoup soup(frame.coords, frame.tris, tri_colors);
 
     cinolib::GLcanvas gui;
     gui.push(&soup);
     gui.depth_cull_markers = false;
     update_handle_helpers(gui,m1,m2);
 
+    /* FPS should count draw calls, not booleans completed!
+    */
+
+    std::atomic<int> count = 0;
+
     uint curr_handle = 0;//*handles.begin();
     GLdouble zbuf = 0;
     gui.callback_mouse_left_click = [&](int mod) -> bool
@@ -188,11 +190,6 @@ int main(int argc, char **argv)
         return false;
     };
 
-    /* FPS should count draw calls, not booleans completed!
-    */
-
-    std::atomic<int> count = 0;
-
     gui.callback_mouse_moved = [&](double x_pos, double y_pos) -> bool
     {
         if(mode_init) return false;
@@ -214,21 +211,11 @@ int main(int argc, char **argv)
             data_ptr->bcs[handle] += delta;
             ARAP(*m_ptr,*data_ptr);
             //
-            bool_coords.clear();
-            bool_tris.clear();
             if(is_m1) update_input_coords(in_coords,arap_m1.xyz_out,0);
             else      update_input_coords(in_coords,arap_m2.xyz_out,m1.num_verts()*3);
-            booleanPipeline(in_coords, in_tris, in_labels, op, bool_coords, bool_tris, bool_labels);
-            count++;
-            n_tri = bool_tris.size()/3;
-            tri_colors.resize(n_tri, c0);
-            for(uint id=0; id<n_tri; ++id)
-                tri_colors[id] = (bool_labels[id][0]) ? c0 : c1;
-            soup = cinolib::DrawableTriangleSoup(bool_coords, bool_tris, tri_colors);
+            scheduler.submit(in_coords, op);
 
             update_handle_helpers(gui,m1,m2);
-            gui.draw();
-
             return true;
         }
         return false;
@@ -248,21 +235,14 @@ int main(int argc, char **argv)
         }
         else if(key==GLFW_KEY_W)
         {
-            std::vector<cinolib::Color> colors(bool_tris.size()/3);
+            std::vector<cinolib::Color> colors(frame.tris.size()/3);
             for(uint i=0; i<colors.size(); ++i)
             {
-                colors[i] = (bool_labels[i][0]) ? cinolib::Color::PASTEL_YELLOW() : cinolib::Color::PASTEL_ORANGE();
+                colors[i] = (frame.labels[i][0]) ? cinolib::Color::PASTEL_YELLOW() : cinolib::Color::PASTEL_ORANGE();
             }
         }
         else return false;
-        bool_coords.clear();
-        bool_tris.clear();
-        booleanPipeline(in_coords, in_tris, in_labels, op, bool_coords, bool_tris, bool_labels);
-        n_tri = bool_tris.size()/3;
-        tri_colors.resize(n_tri, c0);
-        for(uint id=0; id<n_tri; ++id)
-            tri_colors[id] = (bool_labels[id][0]) ? c0 : c1;
-        soup = cinolib::DrawableTriangleSoup(bool_coords, bool_tris, tri_colors);
+        scheduler.submit(op); // the geometry did not change
         return true;
     };
 
@@ -276,6 +256,24 @@ int main(int argc, char **argv)
        }
     });
 
-    return gui.launch();
-}
+    // ui thread
+    glfwMakeContextCurrent(gui.window);
+    while(!glfwWindowShouldClose(gui.window))
+    {
+        if(scheduler.fetch(frame))
+        {
+            uint n_tri = frame.tris.size()/3;
+            tri_colors.resize(n_tri, c0);
+            for(uint id=0; id<n_tri; ++id)
+                tri_colors[id] = (frame.labels[id][0]) ? c0 : c1;
+            soup = cinolib::DrawableTriangleSoup(frame.coords, frame.tris, tri_colors);
+            ++count;
+        }
+        gui.draw();
+        glfwPollEvents();
+    }
 
+    fps_exit_signal.set_value();
+    fps_thread.join();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,586 @@
+/*****************************************************************************************
+ *              MIT License                                                              *
+ *                                                                                       *
+ * Copyright (c) 2022 G. Cherchi, F. Pellacini, M. Attene and M. Livesu                  *
+ *                                                                                       *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this  *
+ * software and associated documentation files (the "Software"), to deal in the Software *
+ * without restriction, including without limitation the rights to use, copy, modify,    *
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to    *
+ * permit persons to whom the Software is furnished to do so, subject to the following   *
+ * conditions:                                                                           *
+ *                                                                                       *
+ * The above copyright notice and this permission notice shall be included in all copies *
+ * or substantial portions of the Software.                                              *
+ *                                                                                       *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,   *
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A         *
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT    *
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION     *
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE        *
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                                *
+ *                                                                                       *
+ * Authors:                                                                              *
+ *      Gianmarco Cherchi (g.cherchi@unica.it)                                           *
+ *      https://www.gianmarcocherchi.com                                                 *
+ *                                                                                       *
+ *      Fabio Pellacini (fabio.pellacini@uniroma1.it)                                    *
+ *      https://pellacini.di.uniroma1.it                                                 *
+ *                                                                                       *
+ *      Marco Attene (marco.attene@ge.imati.cnr.it)                                      *
+ *      https://www.cnr.it/en/people/marco.attene/                                       *
+ *                                                                                       *
+ *      Marco Livesu (marco.livesu@ge.imati.cnr.it)                                      *
+ *      http://pers.ge.imati.cnr.it/livesu/                                              *
+ *                                                                                       *
+ * ***************************************************************************************/
+
+#ifdef _MSC_VER // Workaround for known bugs and issues on MSVC
+#define _HAS_STD_BYTE 0  // https://developercommunity.visualstudio.com/t/error-c2872-byte-ambiguous-symbol/93889
+#define NOMINMAX // https://stackoverflow.com/questions/1825904/error-c2589-on-stdnumeric-limitsdoublemin
+#endif
+
+#include "booleans.h"
+#include "boolean_session.h"
+
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <set>
+#include <tbb/global_control.h>
+
+/* Benchmark of the boolean pipeline on the data shipped with the repository.
+ *
+ * Each case is run for each boolean operation and each number of TBB threads: a few warm-up runs first,
+ * then the timed runs. For each stage the median, 10th and 90th percentile wall times are reported,
+ * together with the input triangles processed per second (median total time).
+ *
+ * ./mesh_booleans_bench [--data=../data/] [--threads=1,2,4,8] [--runs=5] [--warmup=1]
+ *                       [--csv=bench.csv] [--json=bench.json] [--quick] [--broadphase=octree|morton|bvh|dual]
+ *
+ * The pairs are made of a model and a translated copy of itself, so that they always intersect.
+ * --quick only runs the smallest size of each model, --broadphase selects the spatial index used to find
+ * the intersecting triangles and to cast the inside/outside rays (see Broadphase)
+ *
+ * ./mesh_booleans_bench --verify [--data=../data/] [--quick]
+ *
+ * runs no timings, and checks instead that all the broadphase backends give the same (sorted) intersection
+ * list and the same output meshes on the same cases, plus a planar input. The index refitted after moving
+ * one of the meshes must give the same results of a fresh build as well, and turning off the floating point
+ * filter of the pairs (see setTriTriFilter) must not change them. Returns 1 if any check fails
+*/
+
+struct BenchCase
+{
+    std::string name;
+    std::vector<std::string> files; // a single file is paired with a translated copy of itself
+    std::vector<BoolOp> ops;
+};
+
+struct BenchRecord
+{
+    std::string case_name;
+    std::string op;
+    uint threads;
+    uint num_tris;
+    std::vector<PipelineStats> runs;
+};
+
+struct BenchStage
+{
+    const char *name;
+    double PipelineStats::*time;
+};
+
+static const BenchStage bench_stages[] =
+{
+    {"merge",              &PipelineStats::merge_time},
+    {"degenerate_removal", &PipelineStats::degenerate_removal_time},
+    {"triangle_soup",      &PipelineStats::triangle_soup_time},
+    {"octree",             &PipelineStats::octree_time},
+    {"broadphase",         &PipelineStats::broadphase_time},
+    {"classification",     &PipelineStats::classification_time},
+    {"triangulation",      &PipelineStats::triangulation_time},
+    {"patches",            &PipelineStats::patches_time},
+    {"inside_out",         &PipelineStats::inside_out_time},
+    {"selection",          &PipelineStats::selection_time},
+    {"output",             &PipelineStats::output_time},
+    {"total",              &PipelineStats::total_time},
+};
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::string opName(const BoolOp &op)
+{
+    if(op == INTERSECTION) return "intersection";
+    if(op == UNION)        return "union";
+    if(op == SUBTRACTION)  return "subtraction";
+    return "xor";
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline double percentile(std::vector<double> values, double p) // nearest rank
+{
+    if(values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    uint rank = static_cast<uint>(std::ceil(p / 100.0 * values.size()));
+    return values[std::min<uint>(std::max<uint>(rank, 1), static_cast<uint>(values.size())) - 1];
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::vector<double> stageTimes(const BenchRecord &r, const BenchStage &s)
+{
+    std::vector<double> t;
+    for(const PipelineStats &ps : r.runs) t.push_back(ps.*(s.time));
+    return t;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline double medianTotalTime(const BenchRecord &r)
+{
+    std::vector<double> t;
+    for(const PipelineStats &ps : r.runs) t.push_back(ps.total_time);
+    return percentile(t, 50);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void loadCase(const BenchCase &c, std::vector<double> &coords, std::vector<uint> &tris, std::vector<uint> &labels)
+{
+    if(c.files.size() > 1)
+    {
+        loadMultipleFiles(c.files, coords, tris, labels);
+        return;
+    }
+
+    int vert_offset = 0; // first coordinate of the copy
+    loadMultipleFiles({c.files[0], c.files[0]}, coords, tris, labels, vert_offset);
+
+    // translate the copy by a fraction of the bbox diagonal, along a direction not aligned with the axes
+    double min[3] = { DBL_MAX,  DBL_MAX,  DBL_MAX};
+    double max[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+    for(uint i = 0; i < static_cast<uint>(vert_offset); i++)
+    {
+        min[i % 3] = std::min(min[i % 3], coords[i]);
+        max[i % 3] = std::max(max[i % 3], coords[i]);
+    }
+
+    double diag = std::sqrt((max[0]-min[0])*(max[0]-min[0]) + (max[1]-min[1])*(max[1]-min[1]) + (max[2]-min[2])*(max[2]-min[2]));
+    double shift[3] = {0.13 * diag, 0.07 * diag, 0.05 * diag};
+
+    for(uint i = static_cast<uint>(vert_offset); i < coords.size(); i++)
+        coords[i] += shift[i % 3];
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::vector<uint> parseList(const std::string &s)
+{
+    std::vector<uint> l;
+    std::stringstream ss(s);
+    std::string item;
+    while(std::getline(ss, item, ','))
+        if(!item.empty()) l.push_back(static_cast<uint>(std::stoul(item)));
+
+    return l;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// two overlapping square grids on the plane z = 0, the second one rotated: all the intersections are coplanar.
+// The meshes are open, so only their intersection lists are verified
+inline void loadPlanarCase(std::vector<double> &coords, std::vector<uint> &tris, std::vector<uint> &labels)
+{
+    const uint n = 40;
+    const double angle = 0.4;
+    for(uint m = 0; m < 2; m++)
+    {
+        uint offset = static_cast<uint>(coords.size() / 3);
+        for(uint i = 0; i <= n; i++)
+            for(uint j = 0; j <= n; j++)
+            {
+                double x = static_cast<double>(i) / n, y = static_cast<double>(j) / n;
+                if(m == 1)
+                {
+                    double rx = std::cos(angle) * (x - 0.5) - std::sin(angle) * (y - 0.5) + 0.8;
+                    double ry = std::sin(angle) * (x - 0.5) + std::cos(angle) * (y - 0.5) + 0.7;
+                    x = rx;
+                    y = ry;
+                }
+                coords.insert(coords.end(), {x, y, 0.0});
+            }
+
+        for(uint i = 0; i < n; i++)
+            for(uint j = 0; j < n; j++)
+            {
+                uint v0 = offset + i * (n + 1) + j, v1 = v0 + n + 1;
+                tris.insert(tris.end(), {v0, v1, v1 + 1, v0, v1 + 1, v0 + 1});
+                labels.insert(labels.end(), {m, m});
+            }
+    }
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// the input with the mesh of the last label translated by a small offset (same triangles, moved vertices)
+inline std::vector<double> moveLastMesh(const std::vector<double> &coords, const std::vector<uint> &tris, const std::vector<uint> &labels)
+{
+    uint last = *std::max_element(labels.begin(), labels.end());
+    std::set<uint> verts;
+    for(uint t_id = 0; t_id < labels.size(); t_id++)
+        if(labels[t_id] == last) verts.insert({tris[3 * t_id], tris[3 * t_id + 1], tris[3 * t_id + 2]});
+
+    double min_x = DBL_MAX, max_x = -DBL_MAX;
+    for(uint i = 0; i < coords.size(); i += 3)
+    {
+        min_x = std::min(min_x, coords[i]);
+        max_x = std::max(max_x, coords[i]);
+    }
+    double shift = 0.01 * (max_x - min_x);
+
+    std::vector<double> moved = coords;
+    for(uint v_id : verts)
+    {
+        moved[3 * v_id]     += shift;
+        moved[3 * v_id + 1] += 0.5 * shift;
+    }
+    return moved;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// same steps of customArrangementPipeline up to the intersection list. broadphase is refitted if it has
+// been used for the same triangles before
+inline void detectIntersections(const std::vector<double> &in_coords, const std::vector<uint> &in_tris, const std::vector<uint> &in_labels,
+                                Broadphase &broadphase, std::vector<std::pair<uint, uint>> &intersection_list, PipelineStats &stats)
+{
+    point_arena arena;
+    std::vector<genericPoint*> verts;
+    std::vector<uint> tris;
+    std::vector<LabelSet> labels(in_labels.size());
+    std::vector<DuplTriInfo> dupl_triangles;
+
+    for(uint i = 0; i < in_labels.size(); i++) labels[i].set(in_labels[i]);
+
+    double multiplier = computeMultiplier(in_coords);
+    mergeDuplicatedVertices(in_coords, in_tris, arena, verts, tris, true);
+    customRemoveDegenerateAndDuplicatedTriangles(verts, tris, labels, dupl_triangles, true);
+
+    TriangleSoup ts(arena, verts, tris, labels, multiplier, true);
+    intersection_list.clear();
+    customDetectIntersections(ts, intersection_list, broadphase, true, &stats);
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// triangles of a result as coordinates (starting from the smallest vertex, keeping the winding) and labels,
+// sorted: two results are the same mesh iff they are equal, whatever the numbering of their vertices
+inline std::vector<std::vector<double>> canonicalMesh(const std::vector<double> &coords, const std::vector<uint> &tris,
+                                                      const std::vector<LabelSet> &labels)
+{
+    std::vector<std::vector<double>> mesh(labels.size());
+    for(uint t_id = 0; t_id < labels.size(); t_id++)
+    {
+        const uint *t = tris.data() + 3 * t_id;
+        uint first = 0;
+        for(uint i = 1; i < 3; i++)
+            if(std::lexicographical_compare(coords.begin() + 3 * t[i], coords.begin() + 3 * t[i] + 3,
+                                            coords.begin() + 3 * t[first], coords.begin() + 3 * t[first] + 3)) first = i;
+
+        for(uint i = 0; i < 3; i++)
+            mesh[t_id].insert(mesh[t_id].end(), coords.begin() + 3 * t[(first + i) % 3], coords.begin() + 3 * t[(first + i) % 3] + 3);
+        for(uint l : labels[t_id]) mesh[t_id].push_back(l);
+    }
+
+    std::sort(mesh.begin(), mesh.end());
+    return mesh;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline std::vector<std::vector<std::vector<double>>> canonicalMeshes(const std::vector<std::vector<double>> &coords,
+                                                                     const std::vector<std::vector<uint>> &tris,
+                                                                     const std::vector<std::vector<LabelSet>> &labels)
+{
+    std::vector<std::vector<std::vector<double>>> meshes;
+    for(uint i = 0; i < coords.size(); i++) meshes.push_back(canonicalMesh(coords[i], tris[i], labels[i]));
+    return meshes;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline bool check(bool ok, const std::string &case_name, const std::string &what)
+{
+    std::cout << case_name << " " << what << ": " << (ok ? "ok" : "FAILED") << std::endl;
+    return ok;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+// returns the number of failed checks. Without ops only the intersection lists are compared
+inline uint verifyCase(const std::string &name, const std::vector<double> &coords, const std::vector<uint> &tris,
+                       const std::vector<uint> &labels, const std::vector<BoolOp> &ops)
+{
+    const BroadphaseType types[] = {BROADPHASE_OCTREE, BROADPHASE_MORTON, BROADPHASE_BVH, BROADPHASE_DUAL};
+    std::vector<double> moved_coords = moveLastMesh(coords, tris, labels);
+
+    uint num_failed = 0;
+    std::vector<std::pair<uint, uint>> ref_list, ref_moved_list;
+    std::vector<std::vector<std::vector<double>>> ref_meshes, ref_moved_meshes;
+
+    for(BroadphaseType type : types)
+    {
+        std::string backend = broadphaseName(type);
+        std::vector<std::pair<uint, uint>> list, moved_list, fresh_list;
+        PipelineStats stats, moved_stats, fresh_stats;
+
+        std::unique_ptr<Broadphase> broadphase = makeBroadphase(type);
+        detectIntersections(coords, tris, labels, *broadphase, list, stats);
+        if(ref_list.empty()) ref_list = list;
+        if(!check(list == ref_list, name, backend + " intersection list")) num_failed++;
+
+        // the same pairs go through the exact test without the floating point filter
+        std::vector<std::pair<uint, uint>> unfiltered_list;
+        PipelineStats unfiltered_stats;
+        setTriTriFilter(false);
+        detectIntersections(coords, tris, labels, *makeBroadphase(type), unfiltered_list, unfiltered_stats);
+        setTriTriFilter(true);
+        if(!check(unfiltered_list == list && unfiltered_stats.num_filtered_pairs == 0 &&
+                  unfiltered_stats.num_tri_tri_tests == stats.num_tri_tri_tests + stats.num_filtered_pairs, name,
+                  backend + " intersection list without the pair filter")) num_failed++;
+
+        // the same index, refitted after moving the last mesh
+        detectIntersections(moved_coords, tris, labels, *broadphase, moved_list, moved_stats);
+        detectIntersections(moved_coords, tris, labels, *makeBroadphase(type), fresh_list, fresh_stats);
+        if(ref_moved_list.empty()) ref_moved_list = fresh_list;
+        if(!check(moved_stats.octree_refit == 1 && moved_list == fresh_list && fresh_list == ref_moved_list, name,
+                  backend + " refitted intersection list")) num_failed++;
+
+        if(ops.empty()) continue;
+
+        setDefaultBroadphaseType(type);
+
+        std::vector<std::vector<double>> bool_coords;
+        std::vector<std::vector<uint>> bool_tris;
+        std::vector<std::vector<LabelSet>> bool_labels;
+        PipelineStats pipeline_stats;
+        booleanPipeline(coords, tris, labels, ops, bool_coords, bool_tris, bool_labels, &pipeline_stats);
+        std::vector<std::vector<std::vector<double>>> meshes = canonicalMeshes(bool_coords, bool_tris, bool_labels);
+        if(ref_meshes.empty()) ref_meshes = meshes;
+        if(!check(meshes == ref_meshes, name, backend + " output meshes")) num_failed++;
+
+        setTriTriFilter(false);
+        booleanPipeline(coords, tris, labels, ops, bool_coords, bool_tris, bool_labels, &unfiltered_stats);
+        setTriTriFilter(true);
+        if(!check(unfiltered_stats.num_intersecting_pairs == pipeline_stats.num_intersecting_pairs &&
+                  canonicalMeshes(bool_coords, bool_tris, bool_labels) == meshes, name,
+                  backend + " output meshes without the pair filter")) num_failed++;
+
+        // a session refits its index when init gets the moved vertices
+        BooleanSession session, fresh_session;
+        session.init(coords, tris, labels);
+        session.init(moved_coords, tris, labels, &moved_stats);
+        session.evaluate(ops, bool_coords, bool_tris, bool_labels);
+        meshes = canonicalMeshes(bool_coords, bool_tris, bool_labels);
+
+        fresh_session.init(moved_coords, tris, labels);
+        fresh_session.evaluate(ops, bool_coords, bool_tris, bool_labels);
+        std::vector<std::vector<std::vector<double>>> fresh_meshes = canonicalMeshes(bool_coords, bool_tris, bool_labels);
+        if(ref_moved_meshes.empty()) ref_moved_meshes = fresh_meshes;
+        if(!check(moved_stats.octree_refit == 1 && meshes == fresh_meshes && fresh_meshes == ref_moved_meshes, name,
+                  backend + " refitted output meshes")) num_failed++;
+    }
+
+    setDefaultBroadphaseType(BROADPHASE_OCTREE);
+    return num_failed;
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void writeCSV(const std::string &filename, const std::vector<BenchRecord> &records)
+{
+    std::ofstream f(filename);
+    f << "case,op,threads,input_tris,stage,median,p10,p90,tris_per_sec\n";
+
+    for(const BenchRecord &r : records)
+    {
+        double tps = r.num_tris / std::max(medianTotalTime(r), 1e-9);
+
+        for(const BenchStage &s : bench_stages)
+        {
+            std::vector<double> t = stageTimes(r, s);
+            f << r.case_name << "," << r.op << "," << r.threads << "," << r.num_tris << "," << s.name << ","
+              << percentile(t, 50) << "," << percentile(t, 10) << "," << percentile(t, 90) << "," << tps << "\n";
+        }
+    }
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+inline void writeJSON(const std::string &filename, const std::vector<BenchRecord> &records)
+{
+    std::ofstream f(filename);
+    f << "[\n";
+
+    for(uint r_id = 0; r_id < records.size(); r_id++)
+    {
+        const BenchRecord &r = records[r_id];
+        double tps = r.num_tris / std::max(medianTotalTime(r), 1e-9);
+
+        f << "  {\"case\": \"" << r.case_name << "\", \"op\": \"" << r.op << "\", \"threads\": " << r.threads
+          << ", \"input_tris\": " << r.num_tris << ", \"runs\": " << r.runs.size() << ", \"tris_per_sec\": " << tps
+          << ", \"stages\": {";
+
+        for(uint s_id = 0; s_id < sizeof(bench_stages) / sizeof(BenchStage); s_id++)
+        {
+            std::vector<double> t = stageTimes(r, bench_stages[s_id]);
+            f << (s_id ? ", " : "") << "\"" << bench_stages[s_id].name << "\": {\"median\": " << percentile(t, 50)
+              << ", \"p10\": " << percentile(t, 10) << ", \"p90\": " << percentile(t, 90) << "}";
+        }
+
+        f << "}}" << (r_id + 1 < records.size() ? "," : "") << "\n";
+    }
+
+    f << "]\n";
+}
+
+//:::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::::
+
+int main(int argc, char **argv)
+{
+    std::string data_path = "../data/";
+    std::string csv_file  = "bench.csv";
+    std::string json_file = "bench.json";
+    uint num_runs = 5, num_warmup = 1;
+    bool quick = false, verify = false;
+    BroadphaseType broadphase;
+
+    std::vector<uint> threads;
+    for(uint t = 1; t < std::thread::hardware_concurrency(); t *= 2) threads.push_back(t);
+    threads.push_back(std::max(1u, std::thread::hardware_concurrency()));
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string a = argv[i];
+        if(a.rfind("--data=", 0) == 0)         data_path  = a.substr(7);
+        else if(a.rfind("--threads=", 0) == 0) threads    = parseList(a.substr(10));
+        else if(a.rfind("--runs=", 0) == 0)    num_runs   = std::max(1, std::stoi(a.substr(7)));
+        else if(a.rfind("--warmup=", 0) == 0)  num_warmup = static_cast<uint>(std::stoi(a.substr(9)));
+        else if(a.rfind("--csv=", 0) == 0)     csv_file   = a.substr(6);
+        else if(a.rfind("--json=", 0) == 0)    json_file  = a.substr(7);
+        else if(a == "--quick")                quick      = true;
+        else if(a == "--verify")               verify     = true;
+        else if(a.rfind("--broadphase=", 0) == 0 && parseBroadphaseType(a.substr(13), broadphase))
+            setDefaultBroadphaseType(broadphase);
+        else
+        {
+            std::cout << "unknown option " << a << std::endl;
+            return -1;
+        }
+    }
+
+    if(!data_path.empty() && data_path.back() != '/') data_path += '/';
+
+    std::vector<BoolOp> all_ops = {INTERSECTION, UNION, SUBTRACTION};
+
+    std::vector<BenchCase> cases;
+    std::vector<std::vector<std::string>> sizes = {{"bunny25k", "bunny50k", "bunny100k"},
+                                                   {"cow25k", "cow50k", "cow100K"},
+                                                   {"cactus10k", "cactus25k", "cactus50k", "cactus100k"},
+                                                   {"armadillo"},
+                                                   {"fertility"}};
+    for(const auto &model : sizes)
+    {
+        uint num = quick ? 1 : static_cast<uint>(model.size());
+        for(uint i = 0; i < num; i++)
+            cases.push_back({model[i], {data_path + model[i] + ".obj"}, all_ops});
+    }
+
+    // variadic subtraction (see main-stencil)
+    BenchCase stencil = {"stencil", {data_path + "fertility.obj"}, {SUBTRACTION}};
+    for(uint i = 0; i < (quick ? 10u : 30u); i++)
+        stencil.files.push_back(data_path + "spheres/" + std::to_string(i) + ".obj");
+    cases.push_back(stencil);
+
+    if(verify)
+    {
+        uint num_failed = 0;
+        for(const BenchCase &c : cases)
+        {
+            std::vector<double> in_coords;
+            std::vector<uint> in_tris, in_labels;
+            loadCase(c, in_coords, in_tris, in_labels);
+
+            if(in_tris.empty())
+            {
+                std::cerr << "skipping " << c.name << ": cannot load the input" << std::endl;
+                continue;
+            }
+
+            std::vector<BoolOp> ops = c.ops;
+            if(ops.size() > 1) ops.push_back(XOR);
+            num_failed += verifyCase(c.name, in_coords, in_tris, in_labels, ops);
+        }
+
+        std::vector<double> in_coords;
+        std::vector<uint> in_tris, in_labels;
+        loadPlanarCase(in_coords, in_tris, in_labels);
+        num_failed += verifyCase("planar", in_coords, in_tris, in_labels, {});
+
+        std::cout << (num_failed ? std::to_string(num_failed) + " checks failed" : "all checks passed") << std::endl;
+        return num_failed ? 1 : 0;
+    }
+
+    std::vector<BenchRecord> records;
+
+    for(const BenchCase &c : cases)
+    {
+        std::vector<double> in_coords;
+        std::vector<uint> in_tris, in_labels;
+        loadCase(c, in_coords, in_tris, in_labels);
+
+        if(in_tris.empty())
+        {
+            std::cerr << "skipping " << c.name << ": cannot load the input" << std::endl;
+            continue;
+        }
+
+        for(const BoolOp &op : c.ops)
+        {
+            for(uint t : threads)
+            {
+                tbb::global_control gc(tbb::global_control::max_allowed_parallelism, t);
+
+                BenchRecord r = {c.name, opName(op), t, static_cast<uint>(in_tris.size() / 3), {}};
+
+                for(uint run = 0; run < num_warmup + num_runs; run++)
+                {
+                    std::vector<double> bool_coords;
+                    std::vector<uint> bool_tris;
+                    std::vector<LabelSet> bool_labels;
+                    PipelineStats stats;
+
+                    booleanPipeline(in_coords, in_tris, in_labels, op, bool_coords, bool_tris, bool_labels, &stats);
+
+                    if(run >= num_warmup) r.runs.push_back(stats);
+                }
+
+                std::cout << c.name << " " << r.op << " threads: " << t << " median time: "
+                          << medianTotalTime(r) << "s" << std::endl;
+
+                records.push_back(r);
+            }
+        }
+    }
+
+    writeCSV(csv_file, records);
+    writeJSON(json_file, records);
+
+    return 0;
+}
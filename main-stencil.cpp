@@ -56,17 +56,11 @@ int main(int argc, char **argv)
 
     int num_sub = 30;
 
-    if(NBIT < num_sub)
-    {
-        std::cerr << "Set NBIT to a higher number!\n";
-        return 0;
-    }
-
     for(int i = 0; i < num_sub; i++)
         in_files.push_back(stencil_path + std::to_string(i) + ".obj");
 
     std::vector<uint> bool_tris;
-    std::vector<std::bitset<NBIT>> bool_labels;
+    std::vector<LabelSet> bool_labels;
 
     loadMultipleFiles(in_files, in_coords, in_tris, in_labels);
 
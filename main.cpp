@@ -48,36 +48,56 @@ int main(int argc, char **argv)
 {
     BoolOp op;
     std::string file_out;
+    bool print_stats = false;
 
-    if(argc < 5)
+    // options (--name) can be anywhere in the command line
+    std::vector<char *> args;
+    for(int i = 0; i < argc; i++)
+    {
+        BroadphaseType broadphase;
+        if(strcmp(argv[i], "--stats=json") == 0) print_stats = true;
+        else if(strncmp(argv[i], "--broadphase=", 13) == 0 && parseBroadphaseType(argv[i] + 13, broadphase))
+            setDefaultBroadphaseType(broadphase);
+        else if(strncmp(argv[i], "--", 2) == 0)
+        {
+            std::cout << "unknown option " << argv[i] << std::endl;
+            return -1;
+        }
+        else args.push_back(argv[i]);
+    }
+
+    if(args.size() < 5)
     {
         std::cout << "syntax error!" << std::endl;
-        std::cout << "./exact_boolean BOOL_OPERATION (intersection OR union OR subtraction) input1.obj input2.obj output.obj" << std::endl;
+        std::cout << "./exact_boolean BOOL_OPERATION (intersection OR union OR subtraction) input1.obj input2.obj output.obj [--stats=json] [--broadphase=octree|morton|bvh|dual]" << std::endl;
         return -1;
     }
     else
     {
-        if (strcmp(argv[1], "intersection") == 0)       op = INTERSECTION;
-        else if (strcmp(argv[1], "union") == 0)         op = UNION;
-        else if (strcmp(argv[1], "subtraction") == 0)   op = SUBTRACTION;
-        else if (strcmp(argv[1], "xor") == 0)           op = XOR;
+        if (strcmp(args[1], "intersection") == 0)       op = INTERSECTION;
+        else if (strcmp(args[1], "union") == 0)         op = UNION;
+        else if (strcmp(args[1], "subtraction") == 0)   op = SUBTRACTION;
+        else if (strcmp(args[1], "xor") == 0)           op = XOR;
     }
 
-    for(int i = 2; i < (argc -1); i++)
-        files.emplace_back(argv[i]);
+    for(uint i = 2; i < (args.size() -1); i++)
+        files.emplace_back(args[i]);
 
-    file_out = argv[argc-1];
+    file_out = args.back();
 
     std::vector<double> in_coords, bool_coords;
     std::vector<uint> in_tris, bool_tris;
     std::vector<uint> in_labels;
-    std::vector<std::bitset<NBIT>> bool_labels;
+    std::vector<LabelSet> bool_labels;
 
     loadMultipleFiles(files, in_coords, in_tris, in_labels);
 
-    booleanPipeline(in_coords, in_tris, in_labels, op, bool_coords, bool_tris, bool_labels);
+    PipelineStats stats;
+    booleanPipeline(in_coords, in_tris, in_labels, op, bool_coords, bool_tris, bool_labels, print_stats ? &stats : nullptr);
 
     cinolib::write_OBJ(file_out.c_str(), bool_coords, bool_tris, {});
 
+    if(print_stats) std::cout << statsToJSON(stats);
+
     return 0;
 }
\ No newline at end of file